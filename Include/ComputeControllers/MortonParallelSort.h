@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+#include <stdio.h>
+
+#include "Include/ComputeControllers/ParallelSort.h"
+#include "Include/SSBOs/GlslStructLayout.h"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A front end for ParallelSort that sorts SSBOs of a C++ structure by the Morton keys (AKA
+    Z-order curve) of a 2D or 3D position in the structure.  Like TypedParallelSort, the
+    structure needs a GLSL_STRUCT(...) (see GlslStructLayout.h).
+
+    The keys are made on the GPU as part of turning the original data into intermediate data,
+    within the bounding box of the positions, which is also found on the GPU at the start of
+    every sort (see MortonKey.comp).  Going from positions to a Morton sorted order is just
+    Sort().
+
+    Ex:
+        GLSL_STRUCT(Particle, ...);     // at global scope; see GlslStructLayout.h
+
+        OriginalDataSsbo::SHARED_PTR particles =
+            std::make_shared<OriginalDataSsbo>(numParticles, sizeof(Particle));
+        MortonParallelSort<Particle> particleSort(particles, "originalData._position");
+        particleSort.Sort();
+
+    The position expression is in terms of "originalData", an OriginalDataStructure.  It can be
+    a vec2, vec3, or vec4.  2D sorts use its x and y, and 3D sorts use its x, y, and z.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+template<typename OriginalDataType>
+class MortonParallelSort : public ParallelSort
+{
+public:
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Generates the GLSL for the structure and the position, then initializes the base class
+        with them and with a key width that splits evenly between the axes.
+    Parameters:
+        dataToSort              Must have been created with sizeof(OriginalDataType) items.
+        glslPositionExpression  See the class' Description.
+        numDimensions           2 or 3.
+        options                 See ParallelSortOptions.h.  A key width of more than 32 bits
+                                makes 64-bit keys, which have 21 bits per axis in 3D (24 in
+                                2D) instead of 10 (16 in 2D) and take more passes.  Morton keys
+                                are always unsigned integers and can't be segmented, so the key
+                                type and the segment offsets don't apply.
+    Returns:    None
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    MortonParallelSort(const OriginalDataSsbo::SHARED_PTR &dataToSort, const std::string &glslPositionExpression,
+        unsigned int numDimensions = 3, const ParallelSortOptions &options = ParallelSortOptions()) :
+        ParallelSort(dataToSort, GetMortonOptions(numDimensions, options),
+            GlslStruct<OriginalDataType>::Definition("OriginalDataStructure"), std::string(),
+            GetSortPositionDefinition(numDimensions, glslPositionExpression))
+    {
+        if (numDimensions != 2 && numDimensions != 3)
+        {
+            fprintf(stderr, "MortonParallelSort: %u dimensions are not supported; using 3 instead\n", numDimensions);
+        }
+
+        if (options._keyType != PARALLEL_SORT_KEY_TYPE_UNSIGNED_INT || options._segmentOffsets != nullptr)
+        {
+            fprintf(stderr, "MortonParallelSort: Morton keys are unsigned and unsegmented; ignoring the key type and segment offsets\n");
+        }
+
+        if (dataToSort->ItemSizeBytes() != sizeof(OriginalDataType))
+        {
+            fprintf(stderr, "MortonParallelSort: SSBO items are %u bytes, but the structure is %u bytes\n",
+                dataToSort->ItemSizeBytes(), (unsigned int)sizeof(OriginalDataType));
+        }
+    }
+
+private:
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Copies the options with the key width set to the biggest multiple of the number of
+        dimensions that fits in a 32- or 64-bit key, and with unsigned, unsegmented keys.
+        Anything other than 2 dimensions is treated as 3.
+
+        Note: A float only has 24 bits of precision, so more bits per axis than that would
+        only be 0s (2D 64-bit keys are 48 bits).
+    Parameters:
+        numDimensions   Self-explanatory.
+        options         See the constructor.
+    Returns:
+        See Description.
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    static ParallelSortOptions GetMortonOptions(unsigned int numDimensions, const ParallelSortOptions &options)
+    {
+        unsigned int maxKeyWidthBits = (options._keyWidthBits > 32) ? 64 : 32;
+        numDimensions = (numDimensions == 2) ? 2 : 3;
+        unsigned int bitsPerAxis = maxKeyWidthBits / numDimensions;
+        bitsPerAxis = (bitsPerAxis > 24) ? 24 : bitsPerAxis;
+
+        ParallelSortOptions mortonOptions = options;
+        mortonOptions._keyWidthBits = bitsPerAxis * numDimensions;
+        mortonOptions._keyType = PARALLEL_SORT_KEY_TYPE_UNSIGNED_INT;
+        mortonOptions._segmentOffsets = nullptr;
+        return mortonOptions;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Wraps the position expression in the GetSortPosition(...) that MortonKey.comp calls,
+        along with the number of dimensions.  Anything other than 2 dimensions is treated as 3.
+    Parameters:
+        numDimensions           Self-explanatory.
+        glslPositionExpression  Self-explanatory.
+    Returns:
+        The GLSL definitions.
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    static std::string GetSortPositionDefinition(unsigned int numDimensions, const std::string &glslPositionExpression)
+    {
+        std::string positionType = (numDimensions == 2) ? "vec2" : "vec3";
+        return
+            "#define PARALLEL_SORT_MORTON_DIMENSIONS " + std::string((numDimensions == 2) ? "2" : "3") + "\n" +
+            positionType + " GetSortPosition(OriginalDataStructure originalData)\n" +
+            "{\n" +
+            "    return " + positionType + "(" + glslPositionExpression + ");\n" +
+            "}\n";
+    }
+};
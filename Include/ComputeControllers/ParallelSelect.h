@@ -0,0 +1,85 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Include/SSBOs/OriginalDataSsbo.h"
+#include "Include/SSBOs/IntermediateDataSsbo.h"
+#include "Include/SSBOs/SelectStatusSsbo.h"
+#include "Include/ComputeControllers/ParallelSortOptions.h"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    This compute controller finds the k-th smallest key, or the K items with the smallest keys,
+    in an SSBO without sorting it (a radix select).  Ex: The K nearest particles, or the median
+    or 99th percentile of some value.
+
+    It uses the same keys as ParallelSort (the same GetSortKey(...), key widths, key types, and
+    descending order), and it goes over them a digit at a time like the sort does, but from the
+    most significant digit down, and each pass only looks at the items that are still in the
+    running:
+    (1) Count how many candidates have each digit value (see GetSelectDigitCounts.comp)
+    (2) Find the digit value that the wanted key has from the counts (see PickSelectDigit.comp)
+    (3) Select the candidates with smaller digits, drop the ones with bigger digits, and keep
+        the ones with the same digit as the next pass' candidates (see
+        FilterSelectCandidates.comp).
+
+    With random keys, each pass looks at about 1/PARALLEL_SORT_NUM_DIGIT_VALUES of the items
+    that the pass before it did, so almost all the work is in the first pass.  The passes'
+    work group counts are made on the GPU, so nothing is read back to the CPU unless the key
+    itself is asked for.
+
+    Like ParallelSort, an instance is only useful for a single OriginalDataSsbo.  It doesn't
+    change the original data.  Its buffers are bound to the same binding points as
+    ParallelSort's (see SsboBufferBindings.comp), so each select binds its own buffers before it
+    starts, and any number of selects and sorts can be used one after another.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class ParallelSelect
+{
+public:
+    ParallelSelect(const OriginalDataSsbo::SHARED_PTR &dataToSelectFrom,
+        const ParallelSortOptions &options = ParallelSortOptions(),
+        const std::string &originalDataStructureGlsl = std::string(),
+        const std::string &getSortKeyGlsl = std::string());
+    ~ParallelSelect();
+
+    void SelectTopK(unsigned int k, bool sortSelected = false);
+    unsigned long long SelectKthKey(unsigned int k);
+    unsigned long long SelectQuantileKey(double quantile);
+
+    unsigned int NumSelected() const;
+    const SelectStatusSsbo::SHARED_PTR &SelectedIndicesSsbo() const;
+
+private:
+    // the programs are deleted with the instance, so a copy would be left with deleted ones
+    ParallelSelect(const ParallelSelect &) = delete;
+    ParallelSelect &operator=(const ParallelSelect &) = delete;
+
+    void Select(unsigned int targetRank);
+
+    unsigned int _getSelectDigitCountsProgramId;
+    unsigned int _pickSelectDigitProgramId;
+    unsigned int _filterSelectCandidatesProgramId;
+    unsigned int _sortSelectedProgramId;
+
+    // this instance's own program keys (see ShaderStorage::NewUniqueProgramKey(...))
+    std::vector<std::string> _programKeys;
+
+    // the candidates are ping-ponged between the halves of the intermediate data, and the
+    // state and the selected indices are in the select status
+    IntermediateDataSsbo::SHARED_PTR _intermediateDataSsbo;
+    SelectStatusSsbo::SHARED_PTR _selectStatusSsbo;
+
+    OriginalDataSsbo::SHARED_PTR _originalDataSsbo;
+
+    // the keys are this many bits wide, which takes this many passes (see
+    // ParallelSortConstants.comp)
+    unsigned int _keyWidthBits;
+    unsigned int _numPasses;
+
+    // how many items the last top-K select selected
+    unsigned int _numSelected;
+};
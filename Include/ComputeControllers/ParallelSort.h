@@ -2,12 +2,18 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Include/SSBOs/SsboBase.h"
 #include "Include/SSBOs/PrefixSumSsbo.h"
+#include "Include/SSBOs/PrefixScanStatusSsbo.h"
+#include "Include/SSBOs/SortPassesSsbo.h"
 #include "Include/SSBOs/IntermediateDataSsbo.h"
 #include "Include/SSBOs/OriginalDataSsbo.h"
 #include "Include/SSBOs/OriginalDataCopySsbo.h"
+#include "Include/SSBOs/SegmentOffsetsSsbo.h"
+#include "Include/GpuProfiler.h"
+#include "Include/ComputeControllers/ParallelSortOptions.h"
 
 
 /*------------------------------------------------------------------------------------------------
@@ -15,52 +21,194 @@ Description:
     This compute controller is responsible for performing a parallel Radix sort of an SSBO 
     according to a structure-specific element.  For example, suppose there is a Particle 
     structure with position, velocity, mass, etc.  If I want to sort the particles in 3D space 
-    according to a Z-order curve, then I will want to sort the particles by Morton codes.
+    according to a Z-order curve, then I will want to sort the particles by Morton codes.  
+    MortonParallelSort makes those on the GPU from the particles' positions as part of the sort.
     
     Sorting by parallel Radix sort requires going over all the bits in the data to be sorted 
-    one by one, each time:
-    (1) Getting a single bit value
-    (2) Performing a parallel prefix scan by work group
-    (3) Performing a parallel prefix scan over all the work group sums
-    (4) Sorting the data according to the prefix sums.
+    one digit (PARALLEL_SORT_BITS_PER_PASS bits) at a time, each time:
+    (1) Counting how many items in each work group have each digit value
+    (2) Performing a parallel prefix scan by work group over those counts
+    (3) Performing a parallel prefix scan over all the work group sums (and over the sums of 
+        those, and so on, for as many levels as it takes), then adding those back down
+    (4) Sorting the data by digit according to the prefix sums.
 
     If I want to sort the original structures, then I can't just sort by some integer.  I need 
     to associate the data that is being sorted with the original structure.  Enter the 
-    IntermediateData structure, which stores a uint (data to sort over, such as a 
-    3D-position-derived Morton code) and the index into the buffer that the structure originally 
-    came from.
+    intermediate data, which is a uint key (data to sort over, such as a 3D-position-derived 
+    Morton code) and the index into the buffer that the structure originally came from, kept in 
+    separate arrays so that the steps that only need the keys don't read the indices.
+
+    If only the sorted order is needed and not the sorted structures (ex: building a bounding 
+    volume hierarchy over Morton-sorted particles), then the sorted intermediate data can be 
+    the output instead (see SortedIntermediateData.comp), and the original data is left where 
+    it is.  That skips gathering the structures into a copy and copying them back, and the copy 
+    buffer isn't allocated.  Or, if the structures are sorted, the copy and the original data 
+    can trade buffers instead of the copy being copied back.  Big structures (ex: 64-byte 
+    particles) are gathered into the copy by several threads each, a uvec4 at a time (see 
+    SortOriginalDataWide.comp).
+
+    If the data is sorted over and over and only changes a little in between (ex: particles 
+    that were sorted last frame and have moved a little since), then an incremental sort 
+    checks on the GPU whether the keys are already in order and skips the passes if they are.  
+    If none are out of order by more than half a sort tile, then it tries sorting within each 
+    sort tile first, and only runs the passes if that wasn't enough (see 
+    PlanIncrementalSort.comp).
+
+    Steps (1) through (4) can be done in a single dispatch per pass by chaining the work 
+    groups' digit counts together (see SortIntermediateDataChained.comp).  That is the 
+    default.  The chain relies on work groups that are running at the same time being able to 
+    see each other's writes, so the multi-dispatch version is kept around for hardware where 
+    that doesn't work out.
+
+    If only the front of the original data is in use (ex: the live particles in a particle 
+    buffer that has room for many more), then Sort(numItems) sorts only those, and every 
+    dispatch is sized for them.  The intermediate data and the prefix scan buffers are sized 
+    for the number of items that are sorted, not for the whole buffer, so they start out small 
+    and double when a sort doesn't fit (see PrepareToSort(...)).
 
     This class handles the multiple compute shaders that need to be called at each step of the 
     sorting process.  The sorting process requires knowing how big the original buffer is and 
     exactly which buffer is being sorted, so an instance of this class will only be useful for a 
-    single OriginalDataSsbo.  Compute shaders are not as flexible as CPU-bound shaders, so you 
-    have to hold their hand, and the consequence is high coupling.  
+    single OriginalDataSsbo.  Each instance has its own programs and buffers and binds the 
+    buffers at the start of every sort, so there can be one instance per buffer to sort (ex: 
+    several particle systems).  Compute shaders are not as flexible as CPU-bound shaders, so 
+    you have to hold their hand, and the consequence is high coupling.  
     
     The benefit is that it can sort 1,000,000 structures in less than 6 milliseconds (at least 
-    for the OriginalData structures that I'm using in this demo).
+    for the OriginalData structures that I'm using in this demo).  Sort(...) only records the 
+    GPU's work and doesn't wait for it, so that is GPU time.  The timing of each step, the 
+    verification, and the durations.txt report are opt-in (see EnableDiagnostics(...)) because 
+    they make the CPU wait for the GPU after every step.  The GPU profiler (see 
+    EnableGpuProfiling(...)) times each step and each pass on the GPU without waiting.
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 class ParallelSort
 {
 public:
-    ParallelSort(const OriginalDataSsbo::SHARED_PTR &dataToSort);
+    ParallelSort(const OriginalDataSsbo::SHARED_PTR &dataToSort, 
+        const ParallelSortOptions &options = ParallelSortOptions(), 
+        const std::string &originalDataStructureGlsl = std::string(), 
+        const std::string &getSortKeyGlsl = std::string(), const std::string &getSortPositionGlsl = std::string());
+    ~ParallelSort();
 
     void Sort();
+    void Sort(unsigned int numItems);
+    void EnableDiagnostics(bool enabled);
+    void EnableGpuProfiling(bool enabled, unsigned int numFramesInRing = 4);
+    const GpuProfiler *GpuProfile() const;
+    void ResetGpuProfile();
+
+    const IntermediateDataSsbo::SHARED_PTR &SortedIntermediateData() const;
+    const SortPassesSsbo::SHARED_PTR &SortPasses() const;
 
 private:
+    void DispatchPrefixScanLevel(unsigned int level, unsigned int numDigitCounts) const;
+    void GetSortTileGrid(unsigned int numItems, unsigned int &numWorkGroupsX, unsigned int &numWorkGroupsY) const;
+    void PrepareToSort(unsigned int numItems);
+    void BindBuffers() const;
+    void AllocateSortBuffers(unsigned int numSortTiles);
+    long long DiagnosticsLap();
+    long long EndSortStage(unsigned int gpuProfilerStage);
+    void ReportDiagnostics(unsigned int numItems, long long totalSortTime);
+
+    unsigned int _computePositionBoundsProgramId;
     unsigned int _originalDataToIntermediateDataProgramId;
-    unsigned int _getBitForPrefixScansProgramId;
+    unsigned int _countKeysOutOfOrderProgramId;
+    unsigned int _planIncrementalSortProgramId;
+    unsigned int _sortWithinTilesProgramId;
+    unsigned int _planSortPassesProgramId;
+    unsigned int _getDigitCountsForPrefixScansProgramId;
     unsigned int _parallelPrefixScanProgramId;
     unsigned int _sortIntermediateDataProgramId;
+    unsigned int _sortIntermediateDataChainedProgramId;
     unsigned int _sortOriginalDataProgramId;
+    unsigned int _copySortedOriginalDataProgramId;
+
+    // the keys of the programs above, which are this instance's own (see 
+    // ShaderStorage::NewUniqueProgramKey(...)) and are deleted with it
+    std::vector<std::string> _programKeys;
 
     // these are unique to this class and are needed for sorting
+    // Note: The copy is null if the original data isn't sorted (only the intermediate data).
     OriginalDataCopySsbo::SHARED_PTR _originalDataCopySsbo;
     IntermediateDataSsbo::SHARED_PTR _intermediateDataSsbo;
     PrefixSumSsbo::SHARED_PTR _prefixSumSsbo;
+    PrefixScanStatusSsbo::SHARED_PTR _prefixScanStatusSsbo;
+    SortPassesSsbo::SHARED_PTR _sortPassesSsbo;
 
     // need to keep this around until the end of Sort() in order to copy the sorted data back to 
     // the original buffer
     OriginalDataSsbo::SHARED_PTR _originalDataSsbo;
 
+    // null unless the sort is segmented
+    SegmentOffsetsSsbo::SHARED_PTR _segmentOffsetsSsbo;
+
+    // the 2D grid of work groups for shaders that run 1 thread per intermediate data item (1 
+    // work group per sort tile) for the last sort's number of items
+    unsigned int _numWorkGroupsX;
+    unsigned int _numWorkGroupsY;
+    unsigned int _numItemsToSort;
+
+    // the buffers that are sized by the number of sort tiles have room for this many
+    unsigned int _numSortTilesCapacity;
+
+    // the gather into the sorted copy has ORIGINAL_DATA_WORDS_PER_ITEM threads per item if the 
+    // items are big enough for the wide gather (see SortOriginalDataWide.comp), or 1 if not
+    unsigned int _sortOriginalDataNumWorkGroupsX;
+    unsigned int _sortOriginalDataNumWorkGroupsY;
+    unsigned int _sortOriginalDataWordsPerItem;
+
+    // the keys are this many bits wide (segment number included), which takes this many passes 
+    // (see ParallelSortConstants.comp)
+    unsigned int _keyWidthBits;
+    unsigned int _numPasses;
+
+    // if false, use the multi-dispatch digit counting, prefix scan, and sorting
+    bool _useChainedScan;
+
+    // if false, the sorted intermediate data is the output, and the original data is left as 
+    // it is
+    bool _sortOriginalData;
+
+    // if true, the original data and the sorted copy trade buffers at the end of Sort() instead 
+    // of the copy being copied back
+    bool _swapOriginalDataBuffers;
+
+    // if true, check whether the keys are (almost) in order before running the passes, and 
+    // skip the gather and the copy back if they were already in order
+    bool _incrementalSort;
+
+    // the demo's OriginalData is verified after sorting by checking that the _value's go from 
+    // smallest to biggest, so it is only on if the sort is ascending by all 32 bits of _value 
+    // as an unsigned integer (not a user-provided structure, key, or Morton key, a segmented 
+    // sort, which is only sorted within each segment, or original data that isn't sorted)
+    bool _verifyDemoData;
+
+    // the last sort's times for each step, in microseconds, if diagnostics are enabled (see 
+    // EnableDiagnostics(...))
+    bool _diagnosticsEnabled;
+    long long _diagnosticsLapStartMicroseconds;
+    long long _durationOriginalDataToIntermediateData;
+    long long _durationIncrementalSort;
+    long long _durationPlanSortPasses;
+    long long _durationSortOriginalData;
+    long long _durationCopySortedOriginalData;
+    std::vector<long long> _durationsGetDigitCountsForPrefixScan;
+    std::vector<long long> _durationsPrefixScanAll;
+    std::vector<long long> _durationsPrefixScanWorkGroupSums;
+    std::vector<long long> _durationsSortIntermediateData;
+
+    // the GPU profiler's stages (see EnableGpuProfiling(...))
+    // Note: The passes' stages come after the planning's, 1 per pass, and then the sorting of 
+    // the original data's and the copy's.
+    enum
+    {
+        SORT_STAGE_ORIGINAL_DATA_TO_INTERMEDIATE_DATA = 0,
+        SORT_STAGE_INCREMENTAL_SORT,
+        SORT_STAGE_PLAN_SORT_PASSES,
+        SORT_STAGE_FIRST_PASS
+    };
+
+    // null unless GPU profiling is enabled
+    std::unique_ptr<GpuProfiler> _gpuProfiler;
 };
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+
+#include "Include/SSBOs/SegmentOffsetsSsbo.h"
+
+// for PARALLEL_SORT_KEY_TYPE_*
+#include "Shaders/ParallelSort/ParallelSortConstants.comp"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The options that ParallelSort (and its TypedParallelSort and MortonParallelSort front
+    ends), ParallelSelect, and SortedIndex are made with.  They are named instead of being a
+    long list of constructor arguments, where a key width and a bool could trade places
+    without the compiler saying anything.  Set the ones that aren't the default and pass the
+    rest along as they are.
+
+    Ex:
+        ParallelSortOptions options;
+        options._keyType = PARALLEL_SORT_KEY_TYPE_FLOAT;
+        options._descending = true;
+        TypedParallelSort<Particle> depthSort(particles,
+            "PARALLEL_SORT_KEY_FROM_UINT(floatBitsToUint(originalData._depth))", options);
+
+    Each class only uses the options that mean something to it (see their constructors).
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+struct ParallelSortOptions
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Sets the defaults: 32-bit unsigned integer keys from smallest to biggest, the chained
+        scan with subgroups, no segments, and the original data sorted and copied back.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    ParallelSortOptions::ParallelSortOptions() :
+        _keyWidthBits(32),
+        _keyType(PARALLEL_SORT_KEY_TYPE_UNSIGNED_INT),
+        _descending(false),
+        _useChainedScan(true),
+        _useSubgroups(true),
+        _segmentOffsets(nullptr),
+        _sortOriginalData(true),
+        _swapOriginalDataBuffers(false),
+        _incrementalSort(false)
+    {
+    }
+
+    void ValidateKey(const std::string &userName);
+    std::string KeyDefinesGlsl(unsigned int segmentBits = 0) const;
+
+    // how many bits wide the keys are, from 1 to 64 (see ParallelSortConstants.comp)
+    // Note: Narrower keys take fewer passes.  Keys wider than 32 bits are 2 words each.
+    unsigned int _keyWidthBits;
+
+    // PARALLEL_SORT_KEY_TYPE_UNSIGNED_INT, PARALLEL_SORT_KEY_TYPE_SIGNED_INT, or
+    // PARALLEL_SORT_KEY_TYPE_FLOAT
+    // Note: Signed integers and floats are turned into unsigned integers that sort the same
+    // way on the GPU as the keys are read (see EncodeKey(...) in SortKey.comp), so no CPU
+    // pre-pass is needed.
+    unsigned int _keyType;
+
+    // if true, sort (or select) from the biggest key to the smallest
+    bool _descending;
+
+    // if true, each pass' digit counting, prefix scan, and sorting are done in a single
+    // dispatch (see SortIntermediateDataChained.comp); if false, they are done with a dispatch
+    // for the counting, a dispatch per level of the prefix scan on the way up and on the way
+    // down (see ParallelPrefixScan.comp), and a dispatch for the sorting
+    bool _useChainedScan;
+
+    // if true, and if KHR_shader_subgroup or ARB_shader_ballot is supported, then the prefix
+    // scans within work groups (including the ones that rank digits within a sort tile) are
+    // done within subgroups first, and only the subgroups' sums go through shared memory (see
+    // SubgroupScan.comp); if false, they only use shared memory
+    bool _useSubgroups;
+
+    // if not null, then each segment of the original data (see SegmentOffsetsBuffer.comp) is
+    // sorted on its own, all of them with the same dispatches
+    // Note: The segment's number is put above the key, which takes log2(number of segments)
+    // more bits, rounded up.  The key width plus those can't be more than 64 bits.
+    SegmentOffsetsSsbo::SHARED_PTR _segmentOffsets;
+
+    // if false, then Sort() stops after sorting the intermediate data, and the sorted keys and
+    // original indices are the output (see ParallelSort::SortedIntermediateData() and
+    // SortedIntermediateData.comp)
+    // Note: The original data is left as it is, and OriginalDataCopySsbo isn't allocated.
+    bool _sortOriginalData;
+
+    // if true, then at the end of Sort(), the original data's SSBO and the sorted copy trade
+    // buffers (see SsboBase::SwapBufferIds(...)) instead of the copy being copied back, and
+    // ORIGINAL_DATA_BUFFER_BINDING is rebound to the sorted one
+    // Note: The OriginalDataSsbo's BufferId() changes with every sort, so anything that keeps
+    // the ID around (ex: a VAO) has to get it again.  Does nothing if the original data isn't
+    // sorted or if the sort is incremental (which may not write the copy at all).
+    bool _swapOriginalDataBuffers;
+
+    // if true, then before the passes, Sort() counts how many keys are out of order on the
+    // GPU, and if none are, then the passes are skipped
+    // Note: If none are out of order by more than half a sort tile, then the keys are sorted
+    // within each sort tile and counted again, and the passes are skipped if that put them in
+    // order.  If none were out of order to begin with, then the original data isn't touched 
+    // either.  For data that is sorted every frame and is almost in order from the last one.
+    bool _incrementalSort;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Include/ComputeControllers/ParallelSort.h"
+#include "Include/SSBOs/OriginalDataSsbo.h"
+#include "Include/SSBOs/SortedIndexSsbo.h"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    This compute controller keeps a sorted index (keys and indices, like ParallelSort's sorted 
+    intermediate data) over a buffer that items are added to a batch at a time, without 
+    re-sorting everything that was already indexed whenever something is added.  Ex: Particles 
+    that are emitted every frame, or events that are logged as they happen.
+
+    It works like a log-structured merge tree with two levels:
+    (1) New items are written to a small delta buffer (see AddDeltaItems(...)).
+    (2) When the delta is full, it is sorted on its own by a ParallelSort that only sorts the 
+        intermediate data, the delta's items are copied to the end of the indexed data, and 
+        the sorted delta is merged into the sorted run (see MergeSortedDelta.comp).
+    Sorting the delta is a full radix sort, but only of the delta, and the merge reads and 
+    writes each indexed item about once, so adding a batch costs about as much as a copy of 
+    the index instead of a sort of it.
+
+    The sorted run is in the SortedIndexSsbo, which stays bound to its dedicated binding 
+    points (see SortedIndexBuffers.comp), so shaders can use it like a sorted intermediate 
+    data.  The items themselves are not reordered; the indices say where they are in the 
+    indexed data.
+
+    Note: Compaction happens when the delta is full or when MergeDelta() is called, so items 
+    in the delta that haven't been merged yet aren't in the index, and the index starts out 
+    empty (the indexed data's items are expected to be added through the delta).  After a 
+    merge, the indexed data is bound to the original data's binding point and the sorted run 
+    to its own binding points, until another sort or select binds its own buffers.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class SortedIndex
+{
+public:
+    SortedIndex(const OriginalDataSsbo::SHARED_PTR &indexedData, const OriginalDataSsbo::SHARED_PTR &deltaData, 
+        const ParallelSortOptions &options = ParallelSortOptions(), 
+        const std::string &originalDataStructureGlsl = std::string(), 
+        const std::string &getSortKeyGlsl = std::string());
+    ~SortedIndex();
+
+    unsigned int AddDeltaItems(unsigned int numItems);
+    void MergeDelta();
+
+    unsigned int NumIndexedItems() const;
+    unsigned int NumDeltaItems() const;
+    const SortedIndexSsbo::SHARED_PTR &SortedIndexData() const;
+
+private:
+    unsigned int _mergeSortedDeltaProgramId;
+
+    // the merge program's key, which no other instance shares, so the destructor can delete it
+    std::vector<std::string> _programKeys;
+
+    // sorts only the delta's intermediate data, which the merge reads from
+    std::unique_ptr<ParallelSort> _deltaSort;
+
+    SortedIndexSsbo::SHARED_PTR _sortedIndexSsbo;
+    OriginalDataSsbo::SHARED_PTR _indexedDataSsbo;
+    OriginalDataSsbo::SHARED_PTR _deltaDataSsbo;
+
+    // which half of the SortedIndexSsbo has the sorted run (0 or its NumItems())
+    unsigned int _sortedIndexReadOffset;
+
+    unsigned int _numIndexedItems;
+    unsigned int _numDeltaItems;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <stdio.h>
+
+#include "Include/ComputeControllers/ParallelSort.h"
+#include "Include/SSBOs/GlslStructLayout.h"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A front end for ParallelSort that sorts SSBOs of a C++ structure instead of the demo's
+    OriginalData.  The shaders' OriginalDataStructure is generated from the C++ structure's
+    GLSL_STRUCT(...) (see GlslStructLayout.h), which also checks at compile time that the two
+    have the same layout, and GetSortKey(...) is generated from a GLSL expression.  Nothing in
+    Shaders/ needs to be edited.
+
+    Ex:
+        GLSL_STRUCT(Particle, ...);     // at global scope; see GlslStructLayout.h
+
+        OriginalDataSsbo::SHARED_PTR particles =
+            std::make_shared<OriginalDataSsbo>(numParticles, sizeof(Particle));
+        TypedParallelSort<Particle> particleSort(particles,
+            "PARALLEL_SORT_KEY_FROM_UINT(originalData._mortonCode)");
+        particleSort.Sort();
+
+    The key expression is in terms of "originalData", an OriginalDataStructure, and must be a
+    PARALLEL_SORT_KEY (see SortKey.comp).  Give it the key's bits as they are; the key type
+    takes care of signed integers and floats.
+    Ex: For a float depth, "PARALLEL_SORT_KEY_FROM_UINT(floatBitsToUint(originalData._depth))"
+    with an options._keyType of PARALLEL_SORT_KEY_TYPE_FLOAT (see ParallelSortOptions.h).
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+template<typename OriginalDataType>
+class TypedParallelSort : public ParallelSort
+{
+public:
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Generates the GLSL for the structure and the key, then initializes the base class with
+        them.
+    Parameters:
+        dataToSort          Must have been created with sizeof(OriginalDataType) items.
+        glslKeyExpression   See the class' Description.
+        options             See ParallelSortOptions.h.  All of them apply.
+    Returns:    None
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    TypedParallelSort(const OriginalDataSsbo::SHARED_PTR &dataToSort, const std::string &glslKeyExpression,
+        const ParallelSortOptions &options = ParallelSortOptions()) :
+        ParallelSort(dataToSort, options, GlslStruct<OriginalDataType>::Definition("OriginalDataStructure"),
+            GetSortKeyDefinition(glslKeyExpression))
+    {
+        if (dataToSort->ItemSizeBytes() != sizeof(OriginalDataType))
+        {
+            fprintf(stderr, "TypedParallelSort: SSBO items are %u bytes, but the structure is %u bytes\n",
+                dataToSort->ItemSizeBytes(), (unsigned int)sizeof(OriginalDataType));
+        }
+    }
+
+private:
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Wraps the key expression in the GetSortKey(...) that
+        OriginalDataToIntermediateData.comp calls (see GetSortKey.comp for the demo's).
+    Parameters:
+        glslKeyExpression   Self-explanatory.
+    Returns:
+        The GLSL definition of GetSortKey(...).
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    static std::string GetSortKeyDefinition(const std::string &glslKeyExpression)
+    {
+        return
+            "PARALLEL_SORT_KEY GetSortKey(OriginalDataStructure originalData)\n"
+            "{\n"
+            "    return " + glslKeyExpression + ";\n"
+            "}\n";
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Times the steps ("stages") of some GPU work that is done over and over (ex: a sort every
+    frame) with GL_TIMESTAMP queries, which the GPU fills out when it gets to them.  The CPU
+    never waits for them.
+
+    Each run of the work is a "frame": BeginFrame(), then Timestamp(...) at the end of each
+    stage, then EndFrame().  Each frame has its own set of queries from a ring of them, and a
+    frame's results are only read once the GPU says that they are all available, which is
+    usually a frame or two later.  If the ring comes back around to a frame whose results
+    still aren't available, that frame is dropped instead of waited on, so a deeper ring only
+    costs a few more query objects.
+
+    A stage's time is from the timestamp before it (or the start of the frame) to its own
+    timestamp, so it includes everything that the GPU did in between (ex: the barriers).
+    Stages that weren't timestamped in a frame get 0 for that frame.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class GpuProfiler
+{
+public:
+    GpuProfiler(const std::vector<std::string> &stageNames, unsigned int numFramesInRing = 4);
+    ~GpuProfiler();
+
+    void BeginFrame();
+    void Timestamp(unsigned int stage);
+    void EndFrame();
+    void Reset();
+    void ReadAvailableFrames();
+
+    unsigned int NumStages() const;
+    const std::string &StageName(unsigned int stage) const;
+    double LastFrameStageMilliseconds(unsigned int stage) const;
+    double AverageStageMilliseconds(unsigned int stage) const;
+    unsigned int NumFramesRead() const;
+    unsigned int NumFramesDropped() const;
+
+private:
+    bool ReadFrame(unsigned int frameSlot);
+
+    std::vector<std::string> _stageNames;
+    unsigned int _numStages;
+    unsigned int _numFramesInRing;
+
+    // 1 query for the start of each frame plus 1 per stage, for every frame in the ring
+    std::vector<unsigned int> _queryIds;
+
+    // which stages of each frame in the ring got a timestamp, and whether the frame's results
+    // haven't been read yet
+    std::vector<unsigned char> _stageTimestamped;
+    std::vector<unsigned char> _framePending;
+
+    // the ring slot of the frame between BeginFrame() and EndFrame(), and the slot of the
+    // oldest frame that may still be pending
+    unsigned int _currentFrameSlot;
+    unsigned int _oldestFrameSlot;
+    bool _inFrame;
+
+    // in nanoseconds
+    std::vector<unsigned long long> _lastFrameStageTimes;
+    std::vector<unsigned long long> _totalStageTimes;
+
+    unsigned int _numFramesRead;
+    unsigned int _numFramesDropped;
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>      // for offsetof(...) and size_t
+#include <string>
+#include <type_traits>
+
+#include "ThirdParty/glm/vec2.hpp"
+#include "ThirdParty/glm/vec3.hpp"
+#include "ThirdParty/glm/vec4.hpp"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Says which GLSL type a C++ type is and what its std430 alignment is.  Only the types that
+    are the same size in C++ as they are in std430 have a specialization (4-byte scalars and
+    glm vectors of them).  Anything else (ex: bool, double, glm matrices) won't compile as a
+    GLSL_STRUCT_MEMBER(...).
+
+    Note: In std430, a vec3 is aligned like a vec4, but it is only 12 bytes, so a 4-byte scalar
+    can go right after it.  C++ only aligns a glm::vec3 to 4 bytes, so the C++ structure may
+    need explicit padding before a vec3 or a vec4.  The static_assert in GLSL_STRUCT(...) will
+    say so.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+template<typename CppType>
+struct GlslType;
+
+#define GLSL_TYPE(cppType, glslName, std430Alignment) \
+    template<> \
+    struct GlslType<cppType> \
+    { \
+        static constexpr const char *Name() { return glslName; } \
+        static constexpr size_t Alignment() { return std430Alignment; } \
+    }
+
+GLSL_TYPE(unsigned int, "uint", 4);
+GLSL_TYPE(int, "int", 4);
+GLSL_TYPE(float, "float", 4);
+GLSL_TYPE(glm::uvec2, "uvec2", 8);
+GLSL_TYPE(glm::ivec2, "ivec2", 8);
+GLSL_TYPE(glm::vec2, "vec2", 8);
+GLSL_TYPE(glm::uvec3, "uvec3", 16);
+GLSL_TYPE(glm::ivec3, "ivec3", 16);
+GLSL_TYPE(glm::vec3, "vec3", 16);
+GLSL_TYPE(glm::uvec4, "uvec4", 16);
+GLSL_TYPE(glm::ivec4, "ivec4", 16);
+GLSL_TYPE(glm::vec4, "vec4", 16);
+
+#undef GLSL_TYPE
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Everything about a member of a C++ structure that is needed to write the same member in a
+    GLSL structure and to check that they are at the same offset.  Fill it out with
+    GLSL_STRUCT_MEMBER(...).
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+struct GlslStructMember
+{
+    const char *_glslType;
+    const char *_name;
+    size_t _offset;
+    size_t _size;
+    size_t _alignment;
+};
+
+#define GLSL_STRUCT_MEMBER(structType, memberName) \
+    GlslStructMember{ \
+        GlslType<decltype(structType::memberName)>::Name(), \
+        #memberName, \
+        offsetof(structType, memberName), \
+        sizeof(structType::memberName), \
+        GlslType<decltype(structType::memberName)>::Alignment() }
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Self-explanatory.
+Parameters:
+    value       Self-explanatory.
+    multiple    Self-explanatory.
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+constexpr size_t RoundUpToMultiple(size_t value, size_t multiple)
+{
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Checks the members from the given one to the end against the std430 rules: every member
+    starts at the next multiple of its alignment after the member before it, and the structure
+    (which is an array element in the SSBO) is padded out to a multiple of its biggest
+    member's alignment.
+
+    Note: This is recursive instead of a loop because it has to be a C++11 constexpr function
+    to be usable in a static_assert(...).
+Parameters:
+    members         All of the structure's members, in order.
+    memberIndex     The first member to check.
+    expectedOffset  The byte right after the member before this one.
+    maxAlignment    The biggest alignment of the members before this one.
+    structSize      sizeof(...) the C++ structure.
+Returns:
+    True if the C++ structure has the same layout as the std430 structure with the same
+    members, otherwise false.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+template<size_t NumMembers>
+constexpr bool IsStd430Layout(const GlslStructMember(&members)[NumMembers], size_t memberIndex,
+    size_t expectedOffset, size_t maxAlignment, size_t structSize)
+{
+    return (memberIndex == NumMembers) ?
+        (RoundUpToMultiple(expectedOffset, maxAlignment) == structSize) :
+        ((members[memberIndex]._offset == RoundUpToMultiple(expectedOffset, members[memberIndex]._alignment)) &&
+        IsStd430Layout(members, memberIndex + 1, members[memberIndex]._offset + members[memberIndex]._size,
+            (members[memberIndex]._alignment > maxAlignment) ? members[memberIndex]._alignment : maxAlignment,
+            structSize));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Writes out the GLSL structure with the given members.
+Parameters:
+    glslStructName  Ex: "OriginalDataStructure"
+    members         Self-explanatory.
+Returns:
+    The GLSL definition of the structure.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+template<size_t NumMembers>
+std::string GlslStructDefinition(const std::string &glslStructName, const GlslStructMember(&members)[NumMembers])
+{
+    std::string definition = "struct " + glslStructName + "\n{\n";
+    for (size_t memberIndex = 0; memberIndex < NumMembers; memberIndex++)
+    {
+        definition += std::string("    ") + members[memberIndex]._glslType + " " + members[memberIndex]._name + ";\n";
+    }
+    definition += "};\n";
+    return definition;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    GLSL_STRUCT(...) specializes this for a C++ structure so that templates (ex:
+    TypedParallelSort) can get the GLSL version of the structure.  There is no generic version,
+    so using a structure without a GLSL_STRUCT(...) won't compile.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+template<typename CppStruct>
+struct GlslStruct;
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Describes a C++ structure's members, in order, so that the GLSL structure can be generated
+    from it, and checks at compile time that the two have the same layout.  Every member must
+    be listed.  Use at global scope (it specializes GlslStruct<...>).
+
+    Ex:
+        struct Particle
+        {
+            glm::vec3 _position;
+            float _mass;                // fits after a vec3
+            glm::vec4 _velocity;
+            unsigned int _mortonCode;
+            float _padding1;            // pad out to a multiple of a vec4's alignment
+            float _padding2;            // (arrays aren't supported)
+            float _padding3;
+        };
+
+        GLSL_STRUCT(Particle,
+            GLSL_STRUCT_MEMBER(Particle, _position),
+            GLSL_STRUCT_MEMBER(Particle, _mass),
+            GLSL_STRUCT_MEMBER(Particle, _velocity),
+            GLSL_STRUCT_MEMBER(Particle, _mortonCode),
+            GLSL_STRUCT_MEMBER(Particle, _padding1),
+            GLSL_STRUCT_MEMBER(Particle, _padding2),
+            GLSL_STRUCT_MEMBER(Particle, _padding3));
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+#define GLSL_STRUCT(structType, ...) \
+    template<> \
+    struct GlslStruct<structType> \
+    { \
+        static std::string Definition(const std::string &glslStructName) \
+        { \
+            static_assert(std::is_standard_layout<structType>::value, \
+                #structType " must be a standard layout structure to be in an SSBO"); \
+            static constexpr GlslStructMember members[] = { __VA_ARGS__ }; \
+            static_assert(IsStd430Layout(members, 0, 0, 4, sizeof(structType)), \
+                #structType " does not have the same layout as the std430 GLSL structure with the same members (look for a member that needs padding before it, or for missing padding at the end)"); \
+            return GlslStructDefinition(glslStructName, members); \
+        } \
+    }
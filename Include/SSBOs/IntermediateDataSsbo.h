@@ -6,7 +6,9 @@
 Description:
     There is no "swap" in parallel sorting, so this buffer contains enough space for a 
     read/write pair of buffers, each of which is big enough to contain a 
-    PrefixScanBuffer::PrefixSumsWithinGroup array's size of info.
+    PrefixScanBuffer::PrefixSumsWithinGroup array's size of info.  The keys and the original 
+    indices are separate arrays (one after the other) in the buffer, and each is bound to its 
+    own binding point.  See IntermediateSortBuffers.comp.
 
     Intended for use only by the ParallelSort compute controller so that all "num items" 
     calculations are contained.
@@ -15,12 +17,16 @@ Creator:    John Cox, 3/2017
 class IntermediateDataSsbo : public SsboBase
 {
 public:
-    IntermediateDataSsbo(unsigned int numItems);
+    IntermediateDataSsbo(unsigned int numItems, unsigned int numKeyWords);
     typedef std::shared_ptr<IntermediateDataSsbo> SHARED_PTR;
 
+    void Bind() const override;
     void ConfigureConstantUniforms(unsigned int computeProgramId) const override;
     unsigned int NumItems() const;
+    unsigned int IndicesByteOffset() const;
 
 private:
     unsigned int _numItems;
+    unsigned int _numKeyWords;
+    unsigned int _indicesByteOffset;
 };
@@ -13,7 +13,8 @@ Description:
     Note: If it is possible to only operate on the sorted data (ex: sorting particles by morton 
     codes so that a bounding volume hierarchy can be constructed only requires the sorted values 
     and how to find the original particles, not sorting the particles themselves), then this 
-    structure will not be necessary.
+    structure will not be necessary, and ParallelSort doesn't allocate it if it is told not to 
+    sort the original data.
 
     In another demo, this would be ParticleSsbo and would also define ConfigureRender.
 Creator:    John Cox, 3/2017
@@ -21,8 +22,10 @@ Creator:    John Cox, 3/2017
 class OriginalDataCopySsbo : public SsboBase
 {
 public:
-    OriginalDataCopySsbo(unsigned int numItems);
+    OriginalDataCopySsbo(unsigned int numItems, unsigned int itemSizeBytes);
     typedef std::shared_ptr<OriginalDataCopySsbo> SHARED_PTR;
 
+    void Bind() const override;
+
 private:
 };
\ No newline at end of file
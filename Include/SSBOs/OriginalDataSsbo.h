@@ -1,24 +1,30 @@
 #pragma once
 
 #include "Include/SSBOs/SsboBase.h"
+#include "Include/SSBOs/OriginalData.h"
 
 
 /*------------------------------------------------------------------------------------------------
 Description:
     A slightly-more-than-base-case convenience.
 
-    In another demo, this would be ParticleSsbo and would also define ConfigureRender.
+    In another demo, this would be ParticleSsbo and would also define ConfigureRender.  The 
+    items don't have to be the demo's OriginalData structure.  Give the size of whatever 
+    structure the buffer holds (see TypedParallelSort.h).
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 class OriginalDataSsbo : public SsboBase
 {
 public:
-    OriginalDataSsbo(unsigned int numItems);
+    OriginalDataSsbo(unsigned int numItems, unsigned int itemSizeBytes = sizeof(OriginalData));
     typedef std::shared_ptr<OriginalDataSsbo> SHARED_PTR;
 
+    void Bind() const override;
     void ConfigureConstantUniforms(unsigned int computeProgramId) const override;
     unsigned int NumItems() const;
+    unsigned int ItemSizeBytes() const;
 
 private:
     unsigned int _numItems;
+    unsigned int _itemSizeBytes;
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Include/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that the work groups of the single-dispatch sorting pass use to pass 
+    their digit counts along to each other.  See PrefixScanStatusBuffer.comp and 
+    SortIntermediateDataChained.comp.
+
+    Intended for use only by the ParallelSort compute controller.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class PrefixScanStatusSsbo : public SsboBase
+{
+public:
+    PrefixScanStatusSsbo(unsigned int numTiles, unsigned int keyWidthBits);
+    typedef std::shared_ptr<PrefixScanStatusSsbo> SHARED_PTR;
+
+    void Bind() const override;
+
+    void Reset(unsigned int numTilesUsed) const;
+    unsigned int NumTiles() const;
+
+private:
+    unsigned int _numTiles;
+
+    // everything before the tile statuses
+    unsigned int _numUintsBeforeTileStatuses;
+};
@@ -2,12 +2,17 @@
 
 #include "Include/SSBOs/SsboBase.h"
 
+#include <vector>
+
 /*------------------------------------------------------------------------------------------------
 Description:
     Encapsulates the SSBO that is used for calculating prefix sums as part of the parallel radix 
     sorting algorithm.
 
     Note: "Prefix scan", "prefix sum", same thing.
+
+    The buffer holds as many levels of prefix sums as the number of data entries requires.  See 
+    PrefixScanBuffer.comp for what a level is.
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 class PrefixSumSsbo : public SsboBase
@@ -16,11 +21,15 @@ public:
     PrefixSumSsbo(unsigned int numDataEntries);
     typedef std::shared_ptr<PrefixSumSsbo> SHARED_PTR;
 
+    void Bind() const override;
     void ConfigureConstantUniforms(unsigned int computeProgramId) const override;
-    unsigned int NumPerGroupPrefixSums() const;
     unsigned int NumDataEntries() const;
+    unsigned int NumLevels() const;
+    unsigned int LevelOffset(unsigned int level) const;
+    unsigned int LevelSize(unsigned int level) const;
 
 private:
-    unsigned int _numPerGroupPrefixSums;
     unsigned int _numDataEntries;
+    std::vector<unsigned int> _levelOffsets;
+    std::vector<unsigned int> _levelSizes;
 };
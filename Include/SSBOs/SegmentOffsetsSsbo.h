@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Include/SSBOs/SsboBase.h"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO of segment offsets for a segmented sort (see
+    SegmentOffsetsBuffer.comp).  Each segment of the original data is sorted on its own, and
+    they are all sorted by the same dispatches.
+
+    The buffer starts out as all 0s (every item in the last segment).  The user fills it out
+    with the index of the first item of each segment, from smallest to biggest, either with
+    glBufferSubData(...) or with a shader, any time before ParallelSort::Sort().
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class SegmentOffsetsSsbo : public SsboBase
+{
+public:
+    SegmentOffsetsSsbo(unsigned int numSegments);
+    typedef std::shared_ptr<SegmentOffsetsSsbo> SHARED_PTR;
+
+    void Bind() const override;
+    void ConfigureConstantUniforms(unsigned int computeProgramId) const override;
+    unsigned int NumSegments() const;
+
+private:
+    unsigned int _numSegments;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Make sure that it matches the structure of the one with the same name in
+    SelectStatusBuffer.comp.
+
+    The first 3 members are the arguments to glDispatchComputeIndirect(...), so the array of
+    these at the start of the SelectStatusSsbo can be used as the GL_DISPATCH_INDIRECT_BUFFER
+    with an offset of (pass number * sizeof(SelectPass)).
+
+    Note: No padding is necessary because it is all uints, and std430 doesn't pad arrays of
+    structures of uints.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+struct SelectPass
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Initializes members to 0.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    SelectPass::SelectPass() :
+        _numWorkGroupsX(0),
+        _numWorkGroupsY(0),
+        _numWorkGroupsZ(0),
+        _numCandidates(0)
+    {
+    }
+
+    unsigned int _numWorkGroupsX;
+    unsigned int _numWorkGroupsY;
+    unsigned int _numWorkGroupsZ;
+    unsigned int _numCandidates;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Include/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO of a radix select's state and its selected indices (see
+    SelectStatusBuffer.comp).  Like SortPassesSsbo, the passes' work group counts are filled
+    out on the GPU and the buffer doubles as the GL_DISPATCH_INDIRECT_BUFFER.
+
+    The selected indices are after the state in the same buffer, and that range is bound on its
+    own, so to use them in another shader, bind the range at SelectedIndicesByteOffset().
+
+    Intended for use only by the ParallelSelect compute controller (except for reading the
+    selected indices).
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class SelectStatusSsbo : public SsboBase
+{
+public:
+    SelectStatusSsbo(unsigned int numItems, unsigned int numWorkGroupsX, unsigned int numWorkGroupsY, 
+        unsigned int keyWidthBits);
+    typedef std::shared_ptr<SelectStatusSsbo> SHARED_PTR;
+
+    void Bind() const override;
+    void Reset(unsigned int targetRank) const;
+    unsigned int IndirectDispatchOffset(unsigned int passNumber) const;
+    unsigned long long GetSelectedKey() const;
+    unsigned int SelectedIndicesByteOffset() const;
+
+private:
+    unsigned int StatusSizeBytes() const;
+
+    unsigned int _numItems;
+    unsigned int _numWorkGroupsX;
+    unsigned int _numWorkGroupsY;
+    unsigned int _numPasses;
+    unsigned int _numKeyWords;
+    unsigned int _selectedIndicesByteOffset;
+};
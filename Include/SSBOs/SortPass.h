@@ -0,0 +1,41 @@
+#pragma once
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Make sure that it matches the structure of the one with the same name in
+    SortPassesBuffer.comp.
+
+    The first 3 members are the arguments to glDispatchComputeIndirect(...), so an array of
+    these can be used as the GL_DISPATCH_INDIRECT_BUFFER with an offset of
+    (pass number * sizeof(SortPass)).
+
+    Note: No padding is necessary because it is all uints, and std430 doesn't pad arrays of
+    structures of uints.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+struct SortPass
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Initializes members to 0.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 3/2017
+    --------------------------------------------------------------------------------------------*/
+    SortPass::SortPass() :
+        _numWorkGroupsX(0),
+        _numWorkGroupsY(0),
+        _numWorkGroupsZ(0),
+        _intermediateBufferReadOffset(0),
+        _intermediateBufferWriteOffset(0),
+        _statusRegion(0)
+    {
+    }
+
+    unsigned int _numWorkGroupsX;
+    unsigned int _numWorkGroupsY;
+    unsigned int _numWorkGroupsZ;
+    unsigned int _intermediateBufferReadOffset;
+    unsigned int _intermediateBufferWriteOffset;
+    unsigned int _statusRegion;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Include/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that says which Radix Sort passes to run, how many work groups to
+    run them with, and which halves of the intermediate buffer to read from and write to.  It
+    is filled out on the GPU (see PlanSortPasses.comp) and doubles as the buffer of
+    glDispatchComputeIndirect(...) arguments for the passes.  See SortPassesBuffer.comp.
+
+    Intended for use only by the ParallelSort compute controller.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class SortPassesSsbo : public SsboBase
+{
+public:
+    SortPassesSsbo(unsigned int numWorkGroupsX, unsigned int numWorkGroupsY, unsigned int numPasses);
+    typedef std::shared_ptr<SortPassesSsbo> SHARED_PTR;
+
+    void Bind() const override;
+
+    void SetNumWorkGroups(unsigned int numWorkGroupsX, unsigned int numWorkGroupsY);
+    void ConfigureConstantUniforms(unsigned int computeProgramId) const override;
+    unsigned int IndirectDispatchOffset(unsigned int passNumber) const;
+    unsigned int RepairIndirectDispatchOffset() const;
+    unsigned int GatherIndirectDispatchOffset() const;
+    unsigned int GetNumPassesRun() const;
+
+private:
+    unsigned int _numWorkGroupsX;
+    unsigned int _numWorkGroupsY;
+    unsigned int _numPasses;
+};
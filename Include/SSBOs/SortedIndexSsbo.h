@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Include/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO of a SortedIndex's sorted run (see SortedIndexBuffers.comp).  Like 
+    IntermediateDataSsbo, it has room for a read/write pair of key arrays and of index arrays, 
+    but which half is bound is up to the SortedIndex: one run for shaders that use the index, 
+    or both while merging.
+
+    Intended for use only by the SortedIndex compute controller (except for reading the run).
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+class SortedIndexSsbo : public SsboBase
+{
+public:
+    SortedIndexSsbo(unsigned int numItems, unsigned int numKeyWords);
+    typedef std::shared_ptr<SortedIndexSsbo> SHARED_PTR;
+
+    void BindRun(unsigned int runOffset) const;
+    void BindBothRuns() const;
+    unsigned int NumItems() const;
+
+private:
+    unsigned int _numItems;
+    unsigned int _numKeyWords;
+    unsigned int _indicesByteOffset;
+};
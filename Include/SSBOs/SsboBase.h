@@ -18,6 +18,7 @@ public:
 
 
     // derived class needs customized Init(...) function to initialize member values
+    virtual void Bind() const;
     virtual void ConfigureConstantUniforms(unsigned int computeProgramId) const;
     virtual void ConfigureRender(unsigned int renderProgramId, unsigned int drawStyle) const;
 
@@ -26,6 +27,8 @@ public:
     unsigned int DrawStyle() const;
     unsigned int NumVertices() const;
 
+    void SwapBufferIds(SsboBase &other);
+
     //static unsigned int GetStorageBlockBindingPointIndexForBuffer(const std::string &bufferNameInShader);
 
 protected:
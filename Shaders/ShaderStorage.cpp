@@ -29,9 +29,9 @@ Parameters: None
 Returns:    None
 Creator:    John Cox (7-14-2016)
 ------------------------------------------------------------------------------------------------*/
-ShaderStorage::ShaderStorage()
+ShaderStorage::ShaderStorage() :
+    _numUniqueProgramKeys(0)
 {
-    //??anything??
 }
 
 /*------------------------------------------------------------------------------------------------
@@ -97,21 +97,44 @@ Description:
     Prints errors to stderr.
 Parameters: 
     programKey  The name that will be used to refer to this shader for the rest of the program.
-                If it already exists, it prints a message to stderr and immediately returns.
+                If a composite shader under it is still being added to, it prints a message 
+                to stderr and immediately returns.  If one was already compiled under it, then 
+                it starts over.
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 void ShaderStorage::NewCompositeShader(const std::string &programKey)
 {
-    if (_partialShaderContents.find(programKey) != _partialShaderContents.end())
+    _COMPOSITE_SHADER_MAP::iterator itr = _partialShaderContents.find(programKey);
+    if (itr == _partialShaderContents.end())
     {
-        fprintf(stderr, "partial shader file already exists for program key '%s'\n",
-            programKey.c_str());
+        _partialShaderContents.insert({ programKey, _COMPOSITE_SHADER_MAP::value_type::second_type() });
     }
-    else
+    else if (!itr->second.empty())
     {
-        _partialShaderContents.insert({ programKey, _COMPOSITE_SHADER_MAP::value_type::second_type() });
+        fprintf(stderr, "partial shader file already exists for program key '%s'\n",
+            programKey.c_str());
     }
+
+    // else CompileCompositeShader(...) already cleared it, so it is ready for new contents
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Makes a program key that no other program has by putting a number after the given name.  
+    For objects that make their own programs and might have more than one instance (ex: a 
+    ParallelSort for each of several buffers).  Each instance's programs are then its own, so 
+    the instance can delete them with DeleteShader(...) without pulling a program out from 
+    under another instance.
+Parameters:
+    programKeyBase  The name that the program would have if there were only one of it.
+Returns:    
+    The name with " #<number>" on the end.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+std::string ShaderStorage::NewUniqueProgramKey(const std::string &programKeyBase)
+{
+    return programKeyBase + " #" + std::to_string(_numUniqueProgramKeys++);
 }
 
 /*------------------------------------------------------------------------------------------------
@@ -264,6 +287,65 @@ void ShaderStorage::AddPartialShaderFile(const std::string &programKey, const st
     _partialShaderContents[programKey] += ("\n" + fileContents);
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Like AddPartialShaderFile(...), but the contents come from a string instead of a file.  
+    This is for bits of shader code that are only known at runtime (ex: a #define for a size 
+    that the user picked).  It is up to the user to make sure that contents are added in the 
+    correct order.
+
+    Prints its own errors to stderr.
+Parameters:
+    programKey      Must have already been created by NewShader(...).
+    shaderContents  Self-explanatory.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ShaderStorage::AddPartialShaderString(const std::string &programKey, const std::string &shaderContents)
+{
+    if (_partialShaderContents.find(programKey) == _partialShaderContents.end())
+    {
+        fprintf(stderr, "Could not add shader string.  No program key '%s'\n",
+            programKey.c_str());
+        return;
+    }
+
+    if (shaderContents.empty())
+    {
+        fprintf(stderr, "Shader string for program key '%s' is empty\n", programKey.c_str());
+        return;
+    }
+
+    // add a new line just to make sure that there is a clear distinction between any possible 
+    // prior contents and these
+    _partialShaderContents[programKey] += ("\n" + shaderContents);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    For the partial shaders that have a default file that the user can replace with a string 
+    (ex: ParallelSort's OriginalDataStructure, which is the demo's unless a structure of the 
+    user's is given).  Adds the string if there is one, or the file if not.
+Parameters:
+    programKey      Must have already been created by NewShader(...).
+    filePath        Added if the string is empty.
+    shaderContents  Added if not empty.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ShaderStorage::AddPartialShaderFileOrString(const std::string &programKey, const std::string &filePath, 
+    const std::string &shaderContents)
+{
+    if (shaderContents.empty())
+    {
+        AddPartialShaderFile(programKey, filePath);
+    }
+    else
+    {
+        AddPartialShaderString(programKey, shaderContents);
+    }
+}
+
 /*------------------------------------------------------------------------------------------------
 Description:
     Attempts to read the shader file text under the provided program key and compile it into the 
@@ -360,6 +442,10 @@ GLuint ShaderStorage::LinkShader(const std::string &programKey)
         glDeleteShader(shaderId);
     }
 
+    // forget the deleted binaries so that they aren't linked into the next program under 
+    // this key or deleted again
+    itr->second.clear();
+
     // check if the program was built ok
     // Note: Perform this check after the shader objects were already cleaned up.  It makes
     // the program cleanup easier.
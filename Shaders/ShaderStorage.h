@@ -24,10 +24,14 @@ public:
     ~ShaderStorage();
     void NewShader(const std::string &programKey);
     void NewCompositeShader(const std::string &programKey);
+    std::string NewUniqueProgramKey(const std::string &programKeyBase);
     void DeleteShader(const std::string &programKey);
 
     void AddAndCompileShaderFile(const std::string &programKey, const std::string &filePath, const GLenum shaderType);
     void AddPartialShaderFile(const std::string &programKey, const std::string &filePath);
+    void AddPartialShaderString(const std::string &programKey, const std::string &shaderContents);
+    void AddPartialShaderFileOrString(const std::string &programKey, const std::string &filePath, 
+        const std::string &shaderContents);
     void CompileCompositeShader(const std::string &programKey, const GLenum shaderType);
     
     GLuint LinkShader(const std::string &programKey);
@@ -48,6 +52,9 @@ private:
     typedef std::map<std::string, GLuint> _PROGRAM_MAP;
     _PROGRAM_MAP _compiledPrograms;
 
+    // counts the keys made by NewUniqueProgramKey(...) so that no two are the same
+    unsigned int _numUniqueProgramKeys;
+
     // before a shader program is compiled, it is a collection of binaries, so each shader 
     // program can have multiple binaries
     // Note: The typedefs make typing easier when checking for iterator 
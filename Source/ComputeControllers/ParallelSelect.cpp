@@ -0,0 +1,364 @@
+#include "Include/ComputeControllers/ParallelSelect.h"
+
+#include "Shaders/ShaderStorage.h"
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+#include "Shaders/ParallelSort/ParallelSortConstants.comp"
+#include "Shaders/ComputeHeaders/UniformLocations.comp"
+
+#include <stdio.h>
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Generates the compute shaders for the passes of the radix select and allocates the buffers
+    for the candidates and the selected items.  Buffer sizes depend on the size of the original
+    data.  They are expected to remain constant after class creation.
+Parameters:
+    dataToSelectFrom    Self-explanatory.
+    options             See ParallelSortOptions.h.  Only the key width, the key type, and
+                        descending apply.  The select takes key width /
+                        PARALLEL_SORT_BITS_PER_PASS passes, rounded up.  If descending, then
+                        the "smallest" keys are the biggest ones (ex: the top-K are the K
+                        items with the biggest keys, and rank 0 is the biggest key).
+    originalDataStructureGlsl
+    getSortKeyGlsl      The same as ParallelSort's.  TypedParallelSort's generated strings work
+                        here too.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+ParallelSelect::ParallelSelect(const OriginalDataSsbo::SHARED_PTR &dataToSelectFrom,
+    const ParallelSortOptions &options, const std::string &originalDataStructureGlsl,
+    const std::string &getSortKeyGlsl) :
+    _getSelectDigitCountsProgramId(0),
+    _pickSelectDigitProgramId(0),
+    _filterSelectCandidatesProgramId(0),
+    _sortSelectedProgramId(0),
+    _intermediateDataSsbo(nullptr),
+    _selectStatusSsbo(nullptr),
+    _originalDataSsbo(dataToSelectFrom),
+    _keyWidthBits(0),
+    _numPasses(0),
+    _numSelected(0)
+{
+    ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+    std::string shaderKey;
+
+    ParallelSortOptions keyOptions(options);
+    keyOptions.ValidateKey("ParallelSelect");
+    _keyWidthBits = keyOptions._keyWidthBits;
+    _numPasses = PARALLEL_SORT_NUM_PASSES_FOR_KEY_WIDTH(_keyWidthBits);
+    std::string keyDefines = keyOptions.KeyDefinesGlsl();
+
+    // on each pass, count how many candidates have each digit value
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("get select digit counts");
+    shaderStorageRef.NewCompositeShader(shaderKey);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+    shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/OriginalDataStructure.comp", 
+        originalDataStructureGlsl);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SelectStatusBuffer.comp");
+    shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/ParallelSort/GetSortKey.comp", getSortKeyGlsl);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SelectCandidates.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/GetSelectDigitCounts.comp");
+    shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+    _getSelectDigitCountsProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    // then find the wanted key's digit and set up the next pass
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("pick select digit");
+    shaderStorageRef.NewCompositeShader(shaderKey);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SelectStatusBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PickSelectDigit.comp");
+    shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+    _pickSelectDigitProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    // and select, drop, or keep each candidate
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("filter select candidates");
+    shaderStorageRef.NewCompositeShader(shaderKey);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+    shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/OriginalDataStructure.comp", 
+        originalDataStructureGlsl);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SelectStatusBuffer.comp");
+    shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/ParallelSort/GetSortKey.comp", getSortKeyGlsl);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SelectCandidates.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/FilterSelectCandidates.comp");
+    shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+    _filterSelectCandidatesProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    // if asked for, sort the top-K by key after selecting them
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("sort selected");
+    shaderStorageRef.NewCompositeShader(shaderKey);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+    shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/OriginalDataStructure.comp", 
+        originalDataStructureGlsl);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SelectStatusBuffer.comp");
+    shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/ParallelSort/GetSortKey.comp", getSortKeyGlsl);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortSelected.comp");
+    shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+    _sortSelectedProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    // the first pass is 1 thread per original data item, in a 2D grid of work groups if it
+    // takes more than PARALLEL_SORT_MAX_WORK_GROUPS_X of them
+    // Note: The shaders check the candidate index against the number of candidates, so the
+    // grid doesn't have to be padded out like the sort's.
+    unsigned int numItems = dataToSelectFrom->NumItems();
+    unsigned int numWorkGroups = (numItems + PARALLEL_SORT_WORK_GROUP_SIZE_X - 1) / PARALLEL_SORT_WORK_GROUP_SIZE_X;
+    numWorkGroups = (numWorkGroups == 0) ? 1 : numWorkGroups;
+    unsigned int numWorkGroupsY = (numWorkGroups + PARALLEL_SORT_MAX_WORK_GROUPS_X - 1) / PARALLEL_SORT_MAX_WORK_GROUPS_X;
+    unsigned int numWorkGroupsX = (numWorkGroups + numWorkGroupsY - 1) / numWorkGroupsY;
+    _selectStatusSsbo = std::make_unique<SelectStatusSsbo>(numItems, numWorkGroupsX, numWorkGroupsY, _keyWidthBits);
+
+    // the candidates after the first pass are at most all the items
+    _intermediateDataSsbo = std::make_unique<IntermediateDataSsbo>((numItems == 0) ? 1 : numItems,
+        PARALLEL_SORT_NUM_KEY_WORDS_FOR_KEY_WIDTH(_keyWidthBits));
+    _intermediateDataSsbo->ConfigureConstantUniforms(_getSelectDigitCountsProgramId);
+    _intermediateDataSsbo->ConfigureConstantUniforms(_filterSelectCandidatesProgramId);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Deletes this select's programs.  The other instances' programs are under other keys, so 
+    they aren't touched.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+ParallelSelect::~ParallelSelect()
+{
+    ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+    for (size_t keyIndex = 0; keyIndex < _programKeys.size(); keyIndex++)
+    {
+        shaderStorageRef.DeleteShader(_programKeys[keyIndex]);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Selects the K items with the smallest keys (ties with the K-th key are broken arbitrarily)
+    and puts their original indices in the first K of SelectedIndices (see
+    SelectStatusBuffer.comp).  Nothing is read back to the CPU.
+
+    If sortSelected is true, then the K items are also sorted by key (ties by original index)
+    in SortSelected.comp.  That takes K * K comparisons, so it is only done for a K of up to
+    PARALLEL_SELECT_MAX_SORTED_ITEMS.  A bigger K is selected but not sorted, and it says so on
+    stderr.
+Parameters:
+    k               How many items to select.  If it is more than the number of items, then
+                    all of them are selected.
+    sortSelected    See Description.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSelect::SelectTopK(unsigned int k, bool sortSelected)
+{
+    unsigned int numItems = _originalDataSsbo->NumItems();
+    if (k > numItems)
+    {
+        fprintf(stderr, "ParallelSelect: can't select %u of %u items; selecting all of them instead\n", k, numItems);
+        k = numItems;
+    }
+
+    _numSelected = k;
+    if (k == 0)
+    {
+        return;
+    }
+
+    if (sortSelected && k > PARALLEL_SELECT_MAX_SORTED_ITEMS)
+    {
+        fprintf(stderr, "ParallelSelect: can't sort %u selected items (at most %u); selecting them without sorting instead\n", 
+            k, PARALLEL_SELECT_MAX_SORTED_ITEMS);
+        sortSelected = false;
+    }
+
+    // the K-th smallest key has rank K - 1, and the selected items are the ones before it
+    // plus enough of the ties with it to make K
+    Select(k - 1);
+
+    if (sortSelected)
+    {
+        unsigned int numWorkGroups = (k + PARALLEL_SORT_WORK_GROUP_SIZE_X - 1) / PARALLEL_SORT_WORK_GROUP_SIZE_X;
+        unsigned int numWorkGroupsY = (numWorkGroups + PARALLEL_SORT_MAX_WORK_GROUPS_X - 1) / PARALLEL_SORT_MAX_WORK_GROUPS_X;
+        unsigned int numWorkGroupsX = (numWorkGroups + numWorkGroupsY - 1) / numWorkGroupsY;
+        glUseProgram(_sortSelectedProgramId);
+        glDispatchCompute(numWorkGroupsX, numWorkGroupsY, 1);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        // the sorted indices were written to the first half of the intermediate indices
+        // because the selected indices were still being read (see SortSelected.comp)
+        glBindBuffer(GL_COPY_READ_BUFFER, _intermediateDataSsbo->BufferId());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _selectStatusSsbo->BufferId());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            _intermediateDataSsbo->IndicesByteOffset(), _selectStatusSsbo->SelectedIndicesByteOffset(),
+            k * sizeof(unsigned int));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    glUseProgram(0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Finds the key with the given rank and reads it back from the GPU.  This makes the CPU wait
+    for the select to finish.
+
+    Also selects the k + 1 items with the smallest keys, same as SelectTopK(k + 1, false),
+    since it is done anyway.
+Parameters:
+    k   0 for the smallest key, the number of items - 1 for the biggest.
+Returns:
+    The key's bits as they are in the original data (see SelectStatusSsbo::GetSelectedKey()).
+    Ex: For a signed integer key that is narrower than 64 bits, sign-extend it, and for a
+    32-bit float key, reinterpret the low word as a float.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long ParallelSelect::SelectKthKey(unsigned int k)
+{
+    unsigned int numItems = _originalDataSsbo->NumItems();
+    if (numItems == 0)
+    {
+        fprintf(stderr, "ParallelSelect: there are no items to select from\n");
+        return 0;
+    }
+    else if (k >= numItems)
+    {
+        fprintf(stderr, "ParallelSelect: rank %u is out of range for %u items; using the last one instead\n", k, numItems);
+        k = numItems - 1;
+    }
+
+    _numSelected = k + 1;
+    Select(k);
+    glUseProgram(0);
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    return _selectStatusSsbo->GetSelectedKey();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Finds the key at the given quantile by the nearest rank and reads it back from the GPU
+    (see SelectKthKey(...)).  Ex: 0.5 is the median, and 0.99 is the 99th percentile.
+Parameters:
+    quantile    From 0 (the smallest key) to 1 (the biggest key).
+Returns:
+    See SelectKthKey(...).
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long ParallelSelect::SelectQuantileKey(double quantile)
+{
+    unsigned int numItems = _originalDataSsbo->NumItems();
+    quantile = (quantile < 0.0) ? 0.0 : ((quantile > 1.0) ? 1.0 : quantile);
+    unsigned int k = (numItems == 0) ? 0 : static_cast<unsigned int>((quantile * (numItems - 1)) + 0.5);
+
+    return SelectKthKey(k);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for how many of the SelectedIndices the last select filled out.
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ParallelSelect::NumSelected() const
+{
+    return _numSelected;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the buffer that the selected indices are in, for shaders that use them (see
+    SelectStatusSsbo).
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+const SelectStatusSsbo::SHARED_PTR &ParallelSelect::SelectedIndicesSsbo() const
+{
+    return _selectStatusSsbo;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the radix select's passes, from the most significant digit to the least.  Each pass'
+    work group counts are in the SelectStatusBuffer, so each pass only runs as many threads as
+    there are candidates left.
+
+    After this, SelectStatusBuffer::SelectedKey is the key with the target rank, and the first
+    (target rank + 1) SelectedIndices are the items with the smallest keys.
+
+    The buffers are bound first because another select or sort may have bound its own buffers 
+    to the same binding points since the last time.
+Parameters:
+    targetRank  Less than the number of items.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSelect::Select(unsigned int targetRank)
+{
+    _originalDataSsbo->Bind();
+    _intermediateDataSsbo->Bind();
+    _selectStatusSsbo->Bind();
+
+    _selectStatusSsbo->Reset(targetRank);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _selectStatusSsbo->BufferId());
+
+    for (unsigned int passNumber = _numPasses; passNumber-- > 0;)
+    {
+        // the least significant bit of this pass' digit
+        unsigned int bitNumber = passNumber * PARALLEL_SORT_BITS_PER_PASS;
+        GLintptr indirectDispatchOffset = _selectStatusSsbo->IndirectDispatchOffset(passNumber);
+
+        glUseProgram(_getSelectDigitCountsProgramId);
+        glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
+        glDispatchComputeIndirect(indirectDispatchOffset);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // Note: This fills out the next pass' work group counts, so the next pass' dispatches
+        // need the command barrier.
+        glUseProgram(_pickSelectDigitProgramId);
+        glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(_filterSelectCandidatesProgramId);
+        glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
+        glDispatchComputeIndirect(indirectDispatchOffset);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+}
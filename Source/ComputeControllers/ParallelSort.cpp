@@ -4,10 +4,10 @@
 #include "ThirdParty/glload/include/glload/gl_4_4.h"
 
 #include "Include/SSBOs/PrefixSumSsbo.h"
-//#include "Include/SSBOs/IntermediateData.h" // for copying data back and verifying 
 #include "Include/SSBOs/OriginalData.h"     // for copying data back and verifying 
 
 #include "Shaders/ParallelSort/ParallelSortConstants.comp"
+#include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
 #include "Shaders/ComputeHeaders/UniformLocations.comp"
 
 #include <iostream>
@@ -18,6 +18,75 @@
 using std::cout;
 using std::endl;
 
+// KHR_shader_subgroup came after OpenGL 4.4, so glload doesn't have its tokens
+#ifndef GL_SUBGROUP_SUPPORTED_STAGES_KHR
+#define GL_SUBGROUP_SUPPORTED_STAGES_KHR 0x9533
+#define GL_SUBGROUP_SUPPORTED_FEATURES_KHR 0x9534
+#define GL_SUBGROUP_FEATURE_ARITHMETIC_BIT_KHR 0x00000004
+#define GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR 0x00000008
+#endif
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Looks through the OpenGL context's extensions for the one with the given name.
+Parameters:
+    extensionName   Ex: "GL_ARB_shader_ballot"
+Returns:
+    True if the context has the extension, otherwise false.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+static bool IsExtensionSupported(const std::string &extensionName)
+{
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (GLint extensionIndex = 0; extensionIndex < numExtensions; extensionIndex++)
+    {
+        const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, extensionIndex));
+        if (extensionName == name)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Picks the subgroup extension for the prefix scans to use (see SubgroupScan.comp).  
+    KHR_shader_subgroup has the prefix sums built in, so it is preferred, but it also has to 
+    support compute shaders and the ballot and arithmetic functions.  ARB_shader_ballot is 
+    the fallback.
+Parameters: None
+Returns:
+    The shader file that turns on the extension, or an empty string if neither is supported.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+static std::string GetSubgroupExtensionShaderFile()
+{
+    if (IsExtensionSupported("GL_KHR_shader_subgroup"))
+    {
+        GLint supportedStages = 0;
+        GLint supportedFeatures = 0;
+        glGetIntegerv(GL_SUBGROUP_SUPPORTED_STAGES_KHR, &supportedStages);
+        glGetIntegerv(GL_SUBGROUP_SUPPORTED_FEATURES_KHR, &supportedFeatures);
+        GLint requiredFeatures = GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR | GL_SUBGROUP_FEATURE_ARITHMETIC_BIT_KHR;
+        if ((supportedStages & GL_COMPUTE_SHADER_BIT) != 0 && 
+            (supportedFeatures & requiredFeatures) == requiredFeatures)
+        {
+            return "Shaders/ComputeHeaders/KhrShaderSubgroup.comp";
+        }
+    }
+
+    if (IsExtensionSupported("GL_ARB_shader_ballot"))
+    {
+        return "Shaders/ComputeHeaders/ArbShaderBallot.comp";
+    }
+
+    return std::string();
+}
+
 
 /*------------------------------------------------------------------------------------------------
 Description:
@@ -29,395 +98,1316 @@ Description:
     (1) The uniform specifying buffer size can be set for any compute shaders that use it.
     (2) The sorted OriginalDataCopyBuffer can be copied back to the OriginalDataBuffer.
 Parameters:
-    dataToSort  See Description.
+    dataToSort      See Description.
+    options         See ParallelSortOptions.h.  All of them apply.
+    originalDataStructureGlsl   
+                    The GLSL definition of OriginalDataStructure, the structure in the 
+                    OriginalDataSsbo.  If empty, then the demo's structure is used (see 
+                    OriginalDataStructure.comp).
+    getSortKeyGlsl  The GLSL definition of GetSortKey(...), which pulls the key out of an 
+                    OriginalDataStructure.  If empty, then the demo's is used (see 
+                    GetSortKey.comp).
+                    Note: TypedParallelSort generates both of these from a C++ structure.
+    getSortPositionGlsl
+                    If not empty, then the keys are Morton keys (see MortonKey.comp), and this 
+                    is the GLSL definition of PARALLEL_SORT_MORTON_DIMENSIONS and of 
+                    GetSortPosition(...), which pulls the position out of an 
+                    OriginalDataStructure.  getSortKeyGlsl is ignored, and the bounds of the 
+                    positions are found on the GPU at the start of every sort.
+                    Note: MortonParallelSort generates this.
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
-ParallelSort::ParallelSort(const OriginalDataSsbo::SHARED_PTR &dataToSort) :
+ParallelSort::ParallelSort(const OriginalDataSsbo::SHARED_PTR &dataToSort, 
+    const ParallelSortOptions &options, const std::string &originalDataStructureGlsl, 
+    const std::string &getSortKeyGlsl, const std::string &getSortPositionGlsl) :
+    _computePositionBoundsProgramId(0),
     _originalDataToIntermediateDataProgramId(0),
-    _getBitForPrefixScansProgramId(0),
+    _countKeysOutOfOrderProgramId(0),
+    _planIncrementalSortProgramId(0),
+    _sortWithinTilesProgramId(0),
+    _planSortPassesProgramId(0),
+    _getDigitCountsForPrefixScansProgramId(0),
     _parallelPrefixScanProgramId(0),
     _sortIntermediateDataProgramId(0),
+    _sortIntermediateDataChainedProgramId(0),
     _sortOriginalDataProgramId(0),
+    _copySortedOriginalDataProgramId(0),
     _originalDataCopySsbo(nullptr),
     _intermediateDataSsbo(nullptr),
     _prefixSumSsbo(nullptr),
-    _originalDataSsbo(dataToSort)
+    _prefixScanStatusSsbo(nullptr),
+    _sortPassesSsbo(nullptr),
+    _originalDataSsbo(dataToSort),
+    _segmentOffsetsSsbo(nullptr),
+    _numWorkGroupsX(0),
+    _numWorkGroupsY(0),
+    _numItemsToSort(0),
+    _numSortTilesCapacity(0),
+    _sortOriginalDataNumWorkGroupsX(0),
+    _sortOriginalDataNumWorkGroupsY(0),
+    _sortOriginalDataWordsPerItem(1),
+    _keyWidthBits(0),
+    _numPasses(0),
+    _useChainedScan(options._useChainedScan),
+    _sortOriginalData(options._sortOriginalData),
+    _swapOriginalDataBuffers(options._swapOriginalDataBuffers),
+    _incrementalSort(options._incrementalSort),
+    _verifyDemoData(originalDataStructureGlsl.empty() && getSortKeyGlsl.empty() && 
+        getSortPositionGlsl.empty() && options._keyWidthBits == 32 && options._keyType == PARALLEL_SORT_KEY_TYPE_UNSIGNED_INT && 
+        !options._descending && options._segmentOffsets == nullptr && options._sortOriginalData),
+    _diagnosticsEnabled(false),
+    _diagnosticsLapStartMicroseconds(0),
+    _durationOriginalDataToIntermediateData(0),
+    _durationIncrementalSort(0),
+    _durationPlanSortPasses(0),
+    _durationSortOriginalData(0),
+    _durationCopySortedOriginalData(0),
+    _gpuProfiler(nullptr)
 {
     ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
     std::string shaderKey;
 
+    ParallelSortOptions keyOptions(options);
+    keyOptions.ValidateKey("ParallelSort");
+    _keyWidthBits = keyOptions._keyWidthBits;
+
+    // the segment number needs enough bits for the biggest segment number
+    const SegmentOffsetsSsbo::SHARED_PTR &segmentOffsets = options._segmentOffsets;
+    unsigned int segmentBits = 0;
+    if (segmentOffsets != nullptr)
+    {
+        while (segmentBits < 32 && (1ull << segmentBits) < segmentOffsets->NumSegments())
+        {
+            segmentBits++;
+        }
+
+        if (_keyWidthBits + segmentBits > PARALLEL_SORT_MAX_KEY_WIDTH_BITS)
+        {
+            fprintf(stderr, "ParallelSort: %u segments don't fit above a %u-bit key; sorting without segments instead\n", 
+                segmentOffsets->NumSegments(), _keyWidthBits);
+            segmentBits = 0;
+        }
+        else
+        {
+            _segmentOffsetsSsbo = segmentOffsets;
+            _keyWidthBits += segmentBits;
+        }
+    }
+    _numPasses = PARALLEL_SORT_NUM_PASSES_FOR_KEY_WIDTH(_keyWidthBits);
+    std::string keyDefines = keyOptions.KeyDefinesGlsl(segmentBits);
+
+    // the extension has to be turned on right after the version in the shaders that use it
+    std::string subgroupExtensionFile = options._useSubgroups ? GetSubgroupExtensionShaderFile() : std::string();
+
+    // Morton keys need the bounding box of the positions before the keys can be made, and it 
+    // has to be found again on every sort because the positions move
+    if (!getSortPositionGlsl.empty())
+    {
+        shaderKey = shaderStorageRef.NewUniqueProgramKey("compute position bounds");
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/OriginalDataStructure.comp", 
+            originalDataStructureGlsl);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanStatusBuffer.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, getSortPositionGlsl);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/MortonKey.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ComputePositionBounds.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        _computePositionBoundsProgramId = shaderStorageRef.LinkShader(shaderKey);
+        _programKeys.push_back(shaderKey);
+    }
+
     // take a data structure that needs to be sorted by a value (must be unsigned int for radix 
     // sort to work) and put it into an intermediate structure that has the value and the index 
-    // of the original data structure in the OriginalDataBuffer
-    shaderKey = "original data to intermediate data";
+    // of the original data structure in the OriginalDataBuffer, and count the digits for all 
+    // passes while it's at it
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("original data to intermediate data");
     shaderStorageRef.NewCompositeShader(shaderKey);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+    shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/OriginalDataStructure.comp", 
+        originalDataStructureGlsl);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataBuffer.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanStatusBuffer.comp");
+    if (_segmentOffsetsSsbo != nullptr)
+    {
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SegmentOffsetsBuffer.comp");
+    }
+    if (!getSortPositionGlsl.empty())
+    {
+        shaderStorageRef.AddPartialShaderString(shaderKey, getSortPositionGlsl);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/MortonKey.comp");
+    }
+    else
+    {
+        shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/ParallelSort/GetSortKey.comp", getSortKeyGlsl);
+    }
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/OriginalDataToIntermediateData.comp");
     shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
-    shaderStorageRef.LinkShader(shaderKey);
-    _originalDataToIntermediateDataProgramId = shaderStorageRef.GetShaderProgram(shaderKey);
+    _originalDataToIntermediateDataProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    // an incremental sort counts the keys that are out of order, decides whether to sort 
+    // within sort tiles, does so, and counts again
+    if (_incrementalSort)
+    {
+        shaderKey = shaderStorageRef.NewUniqueProgramKey("count keys out of order");
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanStatusBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/CountKeysOutOfOrder.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        _countKeysOutOfOrderProgramId = shaderStorageRef.LinkShader(shaderKey);
+        _programKeys.push_back(shaderKey);
+
+        shaderKey = shaderStorageRef.NewUniqueProgramKey("plan incremental sort");
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanStatusBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PlanIncrementalSort.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        _planIncrementalSortProgramId = shaderStorageRef.LinkShader(shaderKey);
+        _programKeys.push_back(shaderKey);
+
+        shaderKey = shaderStorageRef.NewUniqueProgramKey("sort within tiles");
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortWithinTiles.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        _sortWithinTilesProgramId = shaderStorageRef.LinkShader(shaderKey);
+        _programKeys.push_back(shaderKey);
+    }
 
-    // on each loop in Sort(), pluck out a single bit and add it to the 
-    // PrefixScanBuffer::PrefixSumsWithinGroup array
-    shaderKey = "get bit for prefix sums";
+    // decide which passes to run from the key bits that the last shader found, and set up the 
+    // work group counts and buffer offsets for each pass
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("plan sort passes");
     shaderStorageRef.NewCompositeShader(shaderKey);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanStatusBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PlanSortPasses.comp");
+    shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+    _planSortPassesProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    // on each loop in Sort(), count how many items in each work group have each digit value 
+    // and put the counts in level 0 of PrefixScanBuffer::AllPrefixSums
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("get digit counts for prefix sums");
+    shaderStorageRef.NewCompositeShader(shaderKey);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanBuffer.comp");
-    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/GetBitForPrefixScan.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/GetDigitCountsForPrefixScan.comp");
     shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
-    shaderStorageRef.LinkShader(shaderKey);
-    _getBitForPrefixScansProgramId = shaderStorageRef.GetShaderProgram(shaderKey);
+    _getDigitCountsForPrefixScansProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
 
-    // run the prefix scan over PrefixScanBuffer::PrefixSumsWithinGroup, and after that run the 
-    // scan again over PrefixScanBuffer::PrefixSumsByGroup
-    shaderKey = "parallel prefix scan";
+    // run the prefix scan over each level of the PrefixScanBuffer::AllPrefixSums, from the 
+    // digit counts up to the top level, and then add each level's prefix sums back down to the 
+    // level below it
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("parallel prefix scan");
     shaderStorageRef.NewCompositeShader(shaderKey);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    if (!subgroupExtensionFile.empty())
+    {
+        shaderStorageRef.AddPartialShaderFile(shaderKey, subgroupExtensionFile);
+    }
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SubgroupScan.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/WorkGroupPrefixScan.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelPrefixScan.comp");
     shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
-    shaderStorageRef.LinkShader(shaderKey);
-    _parallelPrefixScanProgramId = shaderStorageRef.GetShaderProgram(shaderKey);
+    _parallelPrefixScanProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
 
     // and finally sort the "read" array from IntermediateSortBuffers into the "write" array
-    shaderKey = "sort intermediate data";
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("sort intermediate data");
     shaderStorageRef.NewCompositeShader(shaderKey);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    if (!subgroupExtensionFile.empty())
+    {
+        shaderStorageRef.AddPartialShaderFile(shaderKey, subgroupExtensionFile);
+    }
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SubgroupScan.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/RankWithinSortTile.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortIntermediateData.comp");
     shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
-    shaderStorageRef.LinkShader(shaderKey);
-    _sortIntermediateDataProgramId = shaderStorageRef.GetShaderProgram(shaderKey);
+    _sortIntermediateDataProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
 
-    // after the loop, sort the original data according to the sorted intermediate data
-    shaderKey = "sort original data";
+    // or do the digit counting, prefix scan, and sorting all in one go
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("sort intermediate data chained");
     shaderStorageRef.NewCompositeShader(shaderKey);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
-    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+    if (!subgroupExtensionFile.empty())
+    {
+        shaderStorageRef.AddPartialShaderFile(shaderKey, subgroupExtensionFile);
+    }
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
-    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
     shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
-    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortOriginalData.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/PrefixScanStatusBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SubgroupScan.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/RankWithinSortTile.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortIntermediateDataChained.comp");
     shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
-    shaderStorageRef.LinkShader(shaderKey);
-    _sortOriginalDataProgramId = shaderStorageRef.GetShaderProgram(shaderKey);
+    _sortIntermediateDataChainedProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    // after the loop, sort the original data according to the sorted intermediate data (unless 
+    // the sorted intermediate data is the output)
+    // Note: Big structures are gathered several threads at a time, a word each, with the 
+    // biggest word that the structure's size is a multiple of (std430 structures are always a 
+    // multiple of 4 bytes).  An incremental sort's copy back goes a word at a time too.
+    unsigned int itemSizeBytes = dataToSort->ItemSizeBytes();
+    bool useWideGather = itemSizeBytes >= PARALLEL_SORT_WIDE_GATHER_MIN_ITEM_BYTES && itemSizeBytes % 4 == 0;
+    unsigned int wordSizeBytes = (itemSizeBytes % 16 == 0) ? 16 : ((itemSizeBytes % 8 == 0) ? 8 : 4);
+    std::string wordDefines =
+        std::string("#define ORIGINAL_DATA_WORD ") + ((wordSizeBytes == 16) ? "uvec4" : ((wordSizeBytes == 8) ? "uvec2" : "uint")) + "\n" +
+        "#define ORIGINAL_DATA_WORDS_PER_ITEM " + std::to_string(itemSizeBytes / wordSizeBytes) + "\n";
+    if (_sortOriginalData && !useWideGather)
+    {
+        shaderKey = shaderStorageRef.NewUniqueProgramKey("sort original data");
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFileOrString(shaderKey, "Shaders/OriginalDataStructure.comp", 
+            originalDataStructureGlsl);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortOriginalData.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        _sortOriginalDataProgramId = shaderStorageRef.LinkShader(shaderKey);
+        _programKeys.push_back(shaderKey);
+    }
+    else if (_sortOriginalData)
+    {
+        _sortOriginalDataWordsPerItem = itemSizeBytes / wordSizeBytes;
+        shaderKey = shaderStorageRef.NewUniqueProgramKey("sort original data wide");
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+        shaderStorageRef.AddPartialShaderString(shaderKey, wordDefines);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataWordsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortOriginalDataWide.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        _sortOriginalDataProgramId = shaderStorageRef.LinkShader(shaderKey);
+        _programKeys.push_back(shaderKey);
+    }
+
+    // an incremental sort skips the gather when the keys were already in order, so it can't 
+    // copy the copy back with glCopyBufferSubData(...) (see CopySortedOriginalData.comp), and 
+    // it can't trade buffers with a copy that may not have been written
+    if (_sortOriginalData && _incrementalSort)
+    {
+        if (_swapOriginalDataBuffers)
+        {
+            fprintf(stderr, "ParallelSort: an incremental sort can't swap the original data buffers; copying the sorted data back instead\n");
+            _swapOriginalDataBuffers = false;
+        }
+
+        shaderKey = shaderStorageRef.NewUniqueProgramKey("copy sorted original data");
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+        shaderStorageRef.AddPartialShaderString(shaderKey, wordDefines);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/OriginalDataWordsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/CopySortedOriginalData.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        _copySortedOriginalDataProgramId = shaderStorageRef.LinkShader(shaderKey);
+        _programKeys.push_back(shaderKey);
+    }
 
     // the size of the OriginalDataBuffer is needed by these shaders, and it is known (as 
     // per my design) only by the OriginalDataSsbo object
     dataToSort->ConfigureConstantUniforms(_originalDataToIntermediateDataProgramId);
-    dataToSort->ConfigureConstantUniforms(_sortOriginalDataProgramId);
-
+    if (_computePositionBoundsProgramId != 0)
+    {
+        dataToSort->ConfigureConstantUniforms(_computePositionBoundsProgramId);
+    }
+    if (_segmentOffsetsSsbo != nullptr)
+    {
+        _segmentOffsetsSsbo->ConfigureConstantUniforms(_originalDataToIntermediateDataProgramId);
+    }
     unsigned int originalDataSize = dataToSort->NumItems();
-    _originalDataCopySsbo = std::make_unique<OriginalDataCopySsbo>(originalDataSize);
-    _prefixSumSsbo = std::make_unique<PrefixSumSsbo>(originalDataSize);
+    if (_sortOriginalData)
+    {
+        dataToSort->ConfigureConstantUniforms(_sortOriginalDataProgramId);
+        if (_copySortedOriginalDataProgramId != 0)
+        {
+            dataToSort->ConfigureConstantUniforms(_copySortedOriginalDataProgramId);
+        }
+        _originalDataCopySsbo = std::make_unique<OriginalDataCopySsbo>(originalDataSize, dataToSort->ItemSizeBytes());
+    }
+    _numItemsToSort = originalDataSize;
 
-    // the PrefixScanBuffer is used in three shaders
-    _prefixSumSsbo->ConfigureConstantUniforms(_getBitForPrefixScansProgramId);
-    _prefixSumSsbo->ConfigureConstantUniforms(_parallelPrefixScanProgramId);
-    _prefixSumSsbo->ConfigureConstantUniforms(_sortIntermediateDataProgramId);
+    // the chained scan needs a status for every digit value of every sort tile
+    // Note: The statuses only have room for 30-bit counts (see PrefixScanStatusBuffer.comp).  
+    // That's more than the SSBOs can hold anyway, but check against the most items that can 
+    // be sorted.
+    unsigned long long maxNumIntermediateItems = static_cast<unsigned long long>(originalDataSize) + PARALLEL_SORT_ITEMS_PER_SORT_TILE;
+    if (_useChainedScan && maxNumIntermediateItems >= (1u << 30))
+    {
+        fprintf(stderr, "ParallelSort: %u items is too many for the chained scan; using the multi-dispatch scan instead\n", originalDataSize);
+        _useChainedScan = false;
+    }
 
-    // see explanation in the PrefixSumSsbo constructor for why there are likely more entries in 
-    // PrefixScanBuffer::PrefixSumsWithinGroup than the requested number of items that need sorting
-    unsigned int numEntriesInPrefixSumBuffer = _prefixSumSsbo->NumDataEntries();
-    _intermediateDataSsbo = std::make_unique<IntermediateDataSsbo>(numEntriesInPrefixSumBuffer);
-    _intermediateDataSsbo->ConfigureConstantUniforms(_originalDataToIntermediateDataProgramId);
-    _intermediateDataSsbo->ConfigureConstantUniforms(_getBitForPrefixScansProgramId);
-    _intermediateDataSsbo->ConfigureConstantUniforms(_sortIntermediateDataProgramId);
+    // the passes that aren't skipped run with 1 work group per sort tile, which Sort(...) sets 
+    // for each sort
+    _sortPassesSsbo = std::make_unique<SortPassesSsbo>(1, 1, _numPasses);
+
+    // the diagnostics' times for each pass are made here so that Sort(...) doesn't allocate 
+    // anything
+    _durationsGetDigitCountsForPrefixScan.resize(_numPasses);
+    _durationsPrefixScanAll.resize(_numPasses);
+    _durationsPrefixScanWorkGroupSums.resize(_numPasses);
+    _durationsSortIntermediateData.resize(_numPasses);
 
+    // the rest of the buffers are as big as the number of sort tiles, which depends on how 
+    // many items are sorted, so they start out with room for 1 tile and grow when a sort 
+    // doesn't fit (see PrepareToSort(...))
+    AllocateSortBuffers(1);
 }
 
 /*------------------------------------------------------------------------------------------------
 Description:
-    This function is the main show of this demo.  It summons shaders to do the following:
-    - Copy original data to intermediate data structures 
-        Note: If you want to sort your OriginalData structure over a particular value, this is 
-        where you decide that.  The rest of the sorting works blindly, bit by bit, on the 
-        IntermediateData::_data value.
-
-    - Loop through all 32 bits in an unsigned integer
-        - Get bits one at a time from the values in the intermediate data structures
-        - Run the parallel prefix scan algorithm on those bit values by work group
-        - Run the parallel prefix scan over each work group's sum
-        - Sort the IntermediateData structures using the resulting prefix sums
-    - Sort the OriginalData items into a copy buffer using the sorted IntermediateData objects
-    - Copy the sorted copy buffer back into OriginalDataBuffer
+    Deletes the compute shader programs that the constructor made.  The buffers clean up after 
+    themselves.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+ParallelSort::~ParallelSort()
+{
+    ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+    for (size_t keyIndex = 0; keyIndex < _programKeys.size(); keyIndex++)
+    {
+        shaderStorageRef.DeleteShader(_programKeys[keyIndex]);
+    }
+}
 
-    The OriginalDataBuffer is now sorted.
+/*------------------------------------------------------------------------------------------------
+Description:
+    Sorts all of the original data.  See Sort(unsigned int).
 Parameters: None
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 void ParallelSort::Sort()
 {
-    // Note: See the explanation at the top of PrefixSumsSsbo.cpp for calculation explanation.
-    unsigned int numItemsInPrefixScanBuffer = _prefixSumSsbo->NumDataEntries();
+    Sort(_originalDataSsbo->NumItems());
+}
 
-    cout << "sorting " << numItemsInPrefixScanBuffer << " items" << endl;
+/*------------------------------------------------------------------------------------------------
+Description:
+    This function is the main show of this demo.  It summons shaders to do the following:
+    - Copy original data to intermediate keys and indices (and count the digits for every pass)
+        Note: If you want to sort your OriginalData structure over a particular value, this is 
+        where you decide that.  The rest of the sorting works blindly, bit by bit, on the 
+        intermediate key.
 
-    // for profiling
-    using namespace std::chrono;
-    steady_clock::time_point parallelSortStart;
-    steady_clock::time_point start;
-    steady_clock::time_point end;
-    long long durationOriginalDataToIntermediateData = 0;
-    long long durationDataVerification = 0;
-    std::vector<long long> durationsUseProgramGetBitForPrefixScan(32);
-    std::vector<long long> durationsUseProgramPrefixScan(32);
-    std::vector<long long> durationsUseProgramSortIntermediateData(32);
-    std::vector<long long> durationsGetBitForPrefixScan(32);
-    std::vector<long long> durationsPrefixScanAll(32);
-    std::vector<long long> durationsPrefixScanWorkGroupSums(32);
-    std::vector<long long> durationsSortIntermediateData(32);
+    - If it is an incremental sort, count the keys that are out of order, and if none are 
+        far out of order, sort within each sort tile (and within tiles that straddle those) and 
+        count again
+    - Decide on the GPU which passes to skip (passes over digits that are the same in every 
+        key, or all of them if an incremental sort's keys are already in order) and fill out 
+        the work group counts and intermediate buffer offsets for every pass
+    - Loop through the key's bits (see _keyWidthBits), PARALLEL_SORT_BITS_PER_PASS at a time, 
+        dispatching with the GPU's work group counts (0 for skipped passes), and either:
+        - Chained: count each work group's digits, chain the counts from work group to work 
+            group, and sort the intermediate keys and indices by digit, all in one dispatch
+        - Or: 
+            - Count how many of each digit value there are in each work group's worth of the 
+                intermediate data structures
+            - Run the parallel prefix scan algorithm on those digit counts by work group, 
+                then over each work group's sum, and over the sums of those sums, and so on, 
+                until a level fits in a single work group, and then add each level's prefix 
+                sums back down to the level below it
+            - Sort the intermediate keys and indices by digit using the resulting prefix sums
+    - If the original data is sorted (the default):
+        - Sort the OriginalData items into a copy buffer using the sorted intermediate indices
+        - Copy the sorted copy buffer back into OriginalDataBuffer, or, if the buffers are 
+            swapped (see ParallelSortOptions::_swapOriginalDataBuffers) and all of the items 
+            were sorted, trade the two buffers' IDs instead so that nothing is copied
+            Note: After a swap, the OriginalDataSsbo that was passed in (and is shared with 
+            the caller) has the sorted buffer's ID, and the old ID is the copy's.  Anything 
+            that held on to the old BufferId() (ex: a VAO) has to get it again.
 
-    // begin
-    parallelSortStart = high_resolution_clock::now();
+        The OriginalDataBuffer is now sorted.
+    - If not, then that's it.  The sorted keys and original indices are the output (see 
+        SortedIntermediateData() and SortedIntermediateData.comp), and the OriginalDataBuffer 
+        is left as it was.
 
-    // for ParallelPrefixScan.comp, which works on 2 items per thread
-    int numWorkGroupsXByItemsPerWorkGroup = numItemsInPrefixScanBuffer / ITEMS_PER_WORK_GROUP;
-    int remainder = numItemsInPrefixScanBuffer % ITEMS_PER_WORK_GROUP;
-    numWorkGroupsXByItemsPerWorkGroup += (remainder == 0) ? 0 : 1;
+    The shaders find their buffers by binding point, and every ParallelSort (and 
+    ParallelSelect) uses the same binding points, so the first thing that a sort does is bind 
+    its own buffers (see BindBuffers()).  Any number of sorters can take turns in the same 
+    OpenGL context without reallocating or reconfiguring anything.
 
-    // for other shaders, which work on 1 item per thread
-    int numWorkGroupsXByWorkGroupSize = numItemsInPrefixScanBuffer / PARALLEL_SORT_WORK_GROUP_SIZE_X;
-    remainder = numItemsInPrefixScanBuffer % PARALLEL_SORT_WORK_GROUP_SIZE_X;
-    numWorkGroupsXByWorkGroupSize += (remainder == 0) ? 0 : 1;
+    Only the first numItems items are sorted (ex: the live particles at the front of a 
+    particle buffer), and everything is dispatched for that many, so a small sort doesn't pay 
+    for the size of the buffer.  The buffers that are sized by the number of items are 
+    reallocated if they are too small for it (see PrepareToSort(...)).
+Parameters: 
+    numItems    How many items at the front of the original data to sort.  Must be <= the 
+                original data's NumItems().
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::Sort(unsigned int numItems)
+{
+    if (numItems > _originalDataSsbo->NumItems())
+    {
+        fprintf(stderr, "ParallelSort: can't sort %u of %u items; sorting all of them instead\n", numItems, _originalDataSsbo->NumItems());
+        numItems = _originalDataSsbo->NumItems();
+    }
+    PrepareToSort(numItems);
+    BindBuffers();
+
+    // for shaders that work on 1 item per thread
+    // Note: The items were padded to a multiple of the sort tile size, which is the work group 
+    // size, and to fill out a 2D grid of work groups (see PrepareToSort(...)), so this is also 
+    // the number of sort tiles.
+    int numWorkGroupsXByWorkGroupSize = _numWorkGroupsX;
+    int numWorkGroupsY = _numWorkGroupsY;
+    unsigned int numDigitCounts = _numWorkGroupsX * _numWorkGroupsY * PARALLEL_SORT_NUM_DIGIT_VALUES;
 
-    // working on a 1D array (X dimension), so these are always 1
-    int numWorkGroupsY = 1;
+    // working on a 1D array (X and maybe Y dimension), so this is always 1
     int numWorkGroupsZ = 1;
 
-    GLuint query = 0;
-    glGenQueries(1, &query);
+    // begin
+    // Note: DiagnosticsLap() and EndSortStage(...) do nothing but return 0 unless diagnostics 
+    // or GPU profiling are enabled.
+    if (_gpuProfiler != nullptr)
+    {
+        _gpuProfiler->BeginFrame();
+    }
+    DiagnosticsLap();
+    long long sortStartMicroseconds = _diagnosticsLapStartMicroseconds;
 
     // moving original data to intermediate data is 1 item per thread
-    start = high_resolution_clock::now();
-    glBeginQuery(GL_TIME_ELAPSED, query);
+    // Note: The digit totals are added to and the chained scan's statuses need to start at 0, 
+    // so clear them first.
+    _prefixScanStatusSsbo->Reset(_numWorkGroupsX * _numWorkGroupsY);
+    if (_computePositionBoundsProgramId != 0)
+    {
+        // the Morton keys need the bounds of the positions (see MortonKey.comp)
+        glUseProgram(_computePositionBoundsProgramId);
+        glDispatchCompute(numWorkGroupsXByWorkGroupSize, numWorkGroupsY, numWorkGroupsZ);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
     glUseProgram(_originalDataToIntermediateDataProgramId);
-    glFinish();
-    glEndQuery(GL_TIME_ELAPSED);
-
-    GLuint64 elapsed = 0;
-    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
-    double milliseconds = elapsed / 1000000.0;
-
-    glBeginQuery(GL_TIME_ELAPSED, query);
     glDispatchCompute(numWorkGroupsXByWorkGroupSize, numWorkGroupsY, numWorkGroupsZ);
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-    glEndQuery(GL_TIME_ELAPSED);
+    _durationOriginalDataToIntermediateData = EndSortStage(SORT_STAGE_ORIGINAL_DATA_TO_INTERMEDIATE_DATA);
 
-    elapsed = 0;
-    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
-    milliseconds = elapsed / 1000000.0;
+    // if the keys are almost in order, try to finish putting them in order without the passes
+    // Note: Whether to sort within the tiles is decided on the GPU, like the passes, so the 
+    // repair is dispatched with the work group counts that PlanIncrementalSort.comp wrote (0 
+    // if the keys are already in order or are too far out of order).
+    if (_incrementalSort)
+    {
+        glUseProgram(_countKeysOutOfOrderProgramId);
+        glUniform1ui(UNIFORM_LOCATION_INCREMENTAL_SORT_STEP, 0);
+        glDispatchCompute(numWorkGroupsXByWorkGroupSize, numWorkGroupsY, numWorkGroupsZ);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
+        glUseProgram(_planIncrementalSortProgramId);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
 
-    end = high_resolution_clock::now();
-    durationOriginalDataToIntermediateData = duration_cast<microseconds>(end - start).count();
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _sortPassesSsbo->BufferId());
+        GLintptr repairDispatchOffset = _sortPassesSsbo->RepairIndirectDispatchOffset();
+        glUseProgram(_sortWithinTilesProgramId);
+        for (unsigned int step = 0; step < 2; step++)
+        {
+            glUniform1ui(UNIFORM_LOCATION_INCREMENTAL_SORT_STEP, step);
+            glDispatchComputeIndirect(repairDispatchOffset);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        glUseProgram(_countKeysOutOfOrderProgramId);
+        glUniform1ui(UNIFORM_LOCATION_INCREMENTAL_SORT_STEP, 1);
+        glDispatchComputeIndirect(repairDispatchOffset);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    }
+    _durationIncrementalSort = EndSortStage(SORT_STAGE_INCREMENTAL_SORT);
+
+    // decide which passes to run
+    // Note: If all the keys are small, then all the high bits are 0, and there is no point in 
+    // sorting by them.  This is decided on the GPU so that the CPU doesn't have to wait for the 
+    // keys to be looked at.  The passes' dispatches read their work group counts from the 
+    // SortPassesBuffer, so skipped passes run 0 work groups.
+    glUseProgram(_planSortPassesProgramId);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _sortPassesSsbo->BufferId());
+    _durationPlanSortPasses = EndSortStage(SORT_STAGE_PLAN_SORT_PASSES);
     
-    // for 32bit unsigned integers, make 32 passes
-    bool writeToSecondBuffer = true;
-    for (unsigned int bitNumber = 0; bitNumber < 32; bitNumber++)
+    // make key width / PARALLEL_SORT_BITS_PER_PASS passes, rounded up (minus any that the GPU 
+    // skips)
+    // Note: Which half of the intermediate buffer each pass reads from and writes to is also 
+    // in the SortPassesBuffer, so there is no swapping to do here.
+    for (unsigned int passNumber = 0; passNumber < _numPasses; passNumber++)
     {
-        // this will either be 0 or half the size of IntermediateDataBuffer
-        unsigned int intermediateDataReadBufferOffset = (unsigned int)!writeToSecondBuffer * numItemsInPrefixScanBuffer;
-        unsigned int intermediateDataWriteBufferOffset = (unsigned int)writeToSecondBuffer * numItemsInPrefixScanBuffer;
+        // the least significant bit of this pass' digit
+        unsigned int bitNumber = passNumber * PARALLEL_SORT_BITS_PER_PASS;
+        GLintptr indirectDispatchOffset = _sortPassesSsbo->IndirectDispatchOffset(passNumber);
 
-        // getting 1 bit value from intermediate data to prefix sum is 1 item per thread
-        start = high_resolution_clock::now();
-        glUseProgram(_getBitForPrefixScansProgramId);
-        end = high_resolution_clock::now();
-        durationsUseProgramGetBitForPrefixScan[bitNumber] = (duration_cast<microseconds>(end - start).count());
-        
-        start = high_resolution_clock::now();
-        glUniform1ui(UNIFORM_LOCATION_INTERMEDIATE_BUFFER_READ_OFFSET, intermediateDataReadBufferOffset);
-        glUniform1ui(UNIFORM_LOCATION_INTERMEDIATE_BUFFER_WRITE_OFFSET, intermediateDataWriteBufferOffset);
-        glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
-        glDispatchCompute(numWorkGroupsXByWorkGroupSize, numWorkGroupsY, numWorkGroupsZ);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-        end = high_resolution_clock::now();
-        durationsGetBitForPrefixScan[bitNumber] = (duration_cast<microseconds>(end - start).count());
+        if (_useChainedScan)
+        {
+            // count, scan, and sort in one go, 1 item per thread
+            glUseProgram(_sortIntermediateDataChainedProgramId);
+            glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
+            glDispatchComputeIndirect(indirectDispatchOffset);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            _durationsSortIntermediateData[passNumber] = EndSortStage(SORT_STAGE_FIRST_PASS + passNumber);
+        }
+        else
+        {
+            // counting digits from intermediate data to prefix sum is 1 item per thread
+            glUseProgram(_getDigitCountsForPrefixScansProgramId);
+            glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
+            glDispatchComputeIndirect(indirectDispatchOffset);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            _durationsGetDigitCountsForPrefixScan[passNumber] = DiagnosticsLap();
 
-        // prefix scan over all values
-        // Note: Parallel prefix scan is 2 items per thread.
-        start = high_resolution_clock::now();
-        glUseProgram(_parallelPrefixScanProgramId);
-        end = high_resolution_clock::now();
-        durationsUseProgramPrefixScan[bitNumber] = (duration_cast<microseconds>(end - start).count());
+            // prefix scan over all digit counts
+            // Note: Parallel prefix scan is PREFIX_SCAN_ITEMS_PER_THREAD items per thread.
+            // Also Note: The prefix scan is run even on skipped passes.  Its work group counts 
+            // are different for every level, and it is harmless because nothing reads the 
+            // results of a skipped pass' scan.
+            glUseProgram(_parallelPrefixScanProgramId);
+            glUniform1ui(UNIFORM_LOCATION_PREFIX_SCAN_ADD_GROUP_SUMS, 0);
+            DispatchPrefixScanLevel(0, numDigitCounts);
+            _durationsPrefixScanAll[passNumber] = DiagnosticsLap();
 
-        start = high_resolution_clock::now();
-        glUniform1ui(UNIFORM_LOCATION_CALCULATE_ALL, 1);
-        glDispatchCompute(numWorkGroupsXByItemsPerWorkGroup, numWorkGroupsY, numWorkGroupsZ);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-        end = high_resolution_clock::now();
-        durationsPrefixScanAll[bitNumber] = (duration_cast<microseconds>(end - start).count());
+            // prefix scan over per-work-group sums, level by level, until the top level (1 
+            // work group) is scanned, then add the prefix sums of each level back down to the 
+            // level below it
+            // Note: Level 0 (the digit counts) does not get the level 1 prefix sums added to 
+            // it.  The sorting shader adds them itself.  That saves a pass over the biggest 
+            // level.
+            unsigned int numPrefixScanLevels = _prefixSumSsbo->NumLevels();
+            for (unsigned int level = 1; level < numPrefixScanLevels; level++)
+            {
+                DispatchPrefixScanLevel(level, numDigitCounts);
+            }
+            glUniform1ui(UNIFORM_LOCATION_PREFIX_SCAN_ADD_GROUP_SUMS, 1);
+            for (unsigned int level = numPrefixScanLevels - 2; level > 0; level--)
+            {
+                DispatchPrefixScanLevel(level, numDigitCounts);
+            }
+            _durationsPrefixScanWorkGroupSums[passNumber] = DiagnosticsLap();
 
-        // prefix scan over per-work-group sums
-        // Note: The PrefixSumsByGroup array is sized to be exactly enough for 1 work group.  It 
-        // makes the prefix sum easier than trying to eliminate excess threads.
-        start = high_resolution_clock::now();
-        glUniform1ui(UNIFORM_LOCATION_CALCULATE_ALL, 0);
-        glDispatchCompute(1, numWorkGroupsY, numWorkGroupsZ);
+            // and sort the intermediate data with the scanned digit counts
+            // Note: The digit counts were made with 1 work group per sort tile, so the sorting 
+            // must use the same number of work groups.
+            glUseProgram(_sortIntermediateDataProgramId);
+            glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
+            glDispatchComputeIndirect(indirectDispatchOffset);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            _durationsSortIntermediateData[passNumber] = EndSortStage(SORT_STAGE_FIRST_PASS + passNumber);
+        }
+    }
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+    // now use the sorted intermediate indices to sort the original data objects into a copy 
+    // buffer (a thread can't swap items in place without racing the others, so the gather must 
+    // write to a dedicated copy buffer)
+    // Note: The shader finds out from the SortPassesBuffer which half of the intermediate 
+    // buffer the last pass wrote to.
+    // Also Note: If the sorted intermediate data is the output, then the sort is done.  If it 
+    // is an incremental sort, then the gather and the copy back are dispatched with the work 
+    // group counts that PlanIncrementalSort.comp wrote, which are 0 if the keys were already 
+    // in order.  The original data is already sorted then, and nothing is moved.
+    if (_sortOriginalData)
+    {
+        glUseProgram(_sortOriginalDataProgramId);
+        if (_incrementalSort)
+        {
+            glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _sortPassesSsbo->BufferId());
+            glDispatchComputeIndirect(_sortPassesSsbo->GatherIndirectDispatchOffset());
+        }
+        else
+        {
+            glDispatchCompute(_sortOriginalDataNumWorkGroupsX, _sortOriginalDataNumWorkGroupsY, numWorkGroupsZ);
+        }
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-        end = high_resolution_clock::now();
-        durationsPrefixScanWorkGroupSums[bitNumber] = (duration_cast<microseconds>(end - start).count());
+        _durationSortOriginalData = EndSortStage(SORT_STAGE_FIRST_PASS + _numPasses);
 
-        // and sort the intermediate data with the scanned values
-        start = high_resolution_clock::now();
-        glUseProgram(_sortIntermediateDataProgramId);
-        end = high_resolution_clock::now();
-        durationsUseProgramSortIntermediateData[bitNumber] = (duration_cast<microseconds>(end - start).count());
+        // and finally, move the sorted original data from the copy buffer back to the OriginalDataBuffer
+        // Note: Or trade buffers so that the copy is the original data, and nothing is moved.  
+        // The shaders find the original data and the copy by binding point, so rebind both.  
+        // The caller shares _originalDataSsbo, so its BufferId() is the sorted one from here on.
+        // Also Note: If only some of the items were sorted, then the copy doesn't have the 
+        // rest of them, so it can't be traded in.  Copy the sorted items back instead.
+        if (_incrementalSort)
+        {
+            // a shader wrote the original data instead of a buffer copy, so whatever reads it 
+            // next (a shader, a draw, or a read back) has to wait for that
+            glUseProgram(_copySortedOriginalDataProgramId);
+            glDispatchComputeIndirect(_sortPassesSsbo->GatherIndirectDispatchOffset());
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+            glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+        }
+        else if (_swapOriginalDataBuffers && numItems == _originalDataSsbo->NumItems())
+        {
+            _originalDataSsbo->SwapBufferIds(*_originalDataCopySsbo);
+            _originalDataSsbo->Bind();
+            _originalDataCopySsbo->Bind();
+        }
+        else
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, _originalDataCopySsbo->BufferId());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, _originalDataSsbo->BufferId());
+            unsigned int sortedDataSizeBytes = numItems * _originalDataSsbo->ItemSizeBytes();
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sortedDataSizeBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        _durationCopySortedOriginalData = EndSortStage(SORT_STAGE_FIRST_PASS + _numPasses + 1);
+    }
+    glUseProgram(0);
 
-        start = high_resolution_clock::now();
-        glUniform1ui(UNIFORM_LOCATION_INTERMEDIATE_BUFFER_READ_OFFSET, intermediateDataReadBufferOffset);
-        glUniform1ui(UNIFORM_LOCATION_INTERMEDIATE_BUFFER_WRITE_OFFSET, intermediateDataWriteBufferOffset);
-        glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
-        glDispatchCompute(numWorkGroupsXByWorkGroupSize, numWorkGroupsY, numWorkGroupsZ);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-        end = high_resolution_clock::now();
-        durationsSortIntermediateData[bitNumber] = (duration_cast<microseconds>(end - start).count());
+    // end sorting
+    if (_gpuProfiler != nullptr)
+    {
+        _gpuProfiler->EndFrame();
+    }
+    if (_diagnosticsEnabled)
+    {
+        long long totalSortTime = _diagnosticsLapStartMicroseconds - sortStartMicroseconds;
+        ReportDiagnostics(numItems, totalSortTime);
+    }
+}
 
-        // now switch intermediate buffers and do it again
-        writeToSecondBuffer = !writeToSecondBuffer;
+/*------------------------------------------------------------------------------------------------
+Description:
+    Turns the diagnostics on or off.  They are off by default.
+
+    With diagnostics on, Sort(...) waits for the GPU to finish after each step so that each 
+    step can be timed, verifies the demo's OriginalData after sorting (see _verifyDemoData), 
+    and prints the times to stdout and to durations.txt.  All of that makes the CPU wait on 
+    the GPU several times per pass, so the total is much longer than the sort itself.
+
+    With diagnostics off, Sort(...) only records dispatches, barriers, and buffer copies, and 
+    it doesn't wait for the GPU or allocate anything unless the sort buffers have to grow (see 
+    PrepareToSort(...)).
+Parameters: 
+    enabled     Self-explanatory.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::EnableDiagnostics(bool enabled)
+{
+    _diagnosticsEnabled = enabled;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Turns the GPU profiler on or off.  It is off by default.
+
+    The profiler times each step of the sort and each pass on the GPU with timestamp queries 
+    (see GpuProfiler), so, unlike the diagnostics, it doesn't make the CPU wait, and it can be 
+    left on in a real program.  Each Sort(...) is a profiler frame, and its results are 
+    available a few sorts later (see GpuProfile()).  If diagnostics are enabled too, then 
+    their report has the profiler's average for each step.
+
+    The stages are, in order:
+    - moving the original data to the intermediate data (and the Morton keys' bounds)
+    - the incremental sort's check and repair (0 if it isn't an incremental sort)
+    - planning the passes
+    - each pass, from the least significant digit up (skipped passes are about 0)
+    - sorting the original data into the copy (0 if only the intermediate data is sorted)
+    - copying or trading the sorted original data back
+Parameters: 
+    enabled         Self-explanatory.
+    numFramesInRing How many sorts can be waiting on the GPU before the profiler drops the 
+                    oldest one's times (see GpuProfiler).
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::EnableGpuProfiling(bool enabled, unsigned int numFramesInRing)
+{
+    if (!enabled)
+    {
+        _gpuProfiler = nullptr;
+        return;
     }
 
-    // now use the sorted IntermediateData objects to sort the original data objects into a copy 
-    // buffer (there is no "swap" in parallel sorting, so must write to a dedicated copy buffer
-    start = high_resolution_clock::now();
-    glUseProgram(_sortOriginalDataProgramId);
-    unsigned int intermediateDataReadBufferOffset = (unsigned int)!writeToSecondBuffer * numItemsInPrefixScanBuffer;
-    glUniform1ui(UNIFORM_LOCATION_INTERMEDIATE_BUFFER_READ_OFFSET, intermediateDataReadBufferOffset);
-    glDispatchCompute(numWorkGroupsXByWorkGroupSize, numWorkGroupsY, numWorkGroupsZ);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-    end = high_resolution_clock::now();
-    unsigned int durationSortOriginalData = duration_cast<microseconds>(end - start).count();
-
-    // and finally, move the sorted original data from the copy buffer back to the OriginalDataBuffer
-    start = high_resolution_clock::now();
-    glBindBuffer(GL_COPY_READ_BUFFER, _originalDataCopySsbo->BufferId());
-    glBindBuffer(GL_COPY_WRITE_BUFFER, _originalDataSsbo->BufferId());
-    unsigned int originalDataBufferSizeBytes = _originalDataSsbo->NumItems() * sizeof(OriginalData);
-    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, originalDataBufferSizeBytes);
-    glBindBuffer(GL_COPY_READ_BUFFER, 0);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
-    end = high_resolution_clock::now();
-    unsigned int durationCopySortedOriginalData = duration_cast<microseconds>(end - start).count();
+    std::vector<std::string> stageNames;
+    stageNames.push_back("original data to intermediate data");
+    stageNames.push_back("incremental sort check and repair");
+    stageNames.push_back("planning sort passes");
+    for (unsigned int passNumber = 0; passNumber < _numPasses; passNumber++)
+    {
+        stageNames.push_back("pass " + std::to_string(passNumber));
+    }
+    stageNames.push_back("sort original data into copy buffer");
+    stageNames.push_back("copy sorted original data");
+    _gpuProfiler = std::make_unique<GpuProfiler>(stageNames, numFramesInRing);
+}
 
-    // end sorting
-    steady_clock::time_point parallelSortEnd = high_resolution_clock::now();
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for the GPU profiler.
+Parameters: None
+Returns:    
+    See Description.  Null unless GPU profiling is enabled (see EnableGpuProfiling(...)).
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+const GpuProfiler *ParallelSort::GpuProfile() const
+{
+    return _gpuProfiler.get();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Starts the GPU profiler's averages over (ex: after the first few sorts, which are slowed 
+    down by the driver getting the shaders ready).  Does nothing if GPU profiling isn't 
+    enabled.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::ResetGpuProfile()
+{
+    if (_gpuProfiler != nullptr)
+    {
+        _gpuProfiler->Reset();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Marks the end of a step of the sort for the GPU profiler and for the diagnostics, if 
+    either is enabled.
+Parameters: 
+    gpuProfilerStage    See EnableGpuProfiling(...).
+Returns:    
+    See DiagnosticsLap().
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+long long ParallelSort::EndSortStage(unsigned int gpuProfilerStage)
+{
+    if (_gpuProfiler != nullptr)
+    {
+        _gpuProfiler->Timestamp(gpuProfilerStage);
+    }
+
+    return DiagnosticsLap();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    For the diagnostics' timing of each step of the sort.  Waits for the GPU to finish 
+    everything so far and starts the next lap.  Does nothing if diagnostics aren't enabled.
+Parameters: None
+Returns:    
+    How many microseconds it has been since the last lap, or 0 if diagnostics aren't enabled.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+long long ParallelSort::DiagnosticsLap()
+{
+    if (!_diagnosticsEnabled)
+    {
+        return 0;
+    }
+
+    using namespace std::chrono;
+    glFinish();
+    long long now = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    long long lapMicroseconds = now - _diagnosticsLapStartMicroseconds;
+    _diagnosticsLapStartMicroseconds = now;
+    return lapMicroseconds;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Verifies the sorted data (if it is the demo's OriginalData) and writes the last sort's 
+    times to stdout and to a text file so that I can dump them into an Excel spreadsheet.  
+    Reads from the GPU, so it makes the CPU wait.
+Parameters: 
+    numItems        How many items were sorted.
+    totalSortTime   In microseconds, from the start of the sort to the end.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::ReportDiagnostics(unsigned int numItems, long long totalSortTime)
+{
+    using namespace std::chrono;
+    steady_clock::time_point start;
+    steady_clock::time_point end;
 
     // verify sorted data
-    start = high_resolution_clock::now();
-    unsigned int startingIndex = 0;
-    std::vector<OriginalData> checkOriginalData(_originalDataSsbo->NumItems());
-    unsigned int bufferSizeBytes = checkOriginalData.size() * sizeof(OriginalData);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _originalDataSsbo->BufferId());
-    void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, startingIndex, bufferSizeBytes, GL_MAP_READ_BIT);
-    memcpy(checkOriginalData.data(), bufferPtr, bufferSizeBytes);
-    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-
-    // check
-    for (unsigned int i = 1; i < checkOriginalData.size(); i++)
-    {
-        unsigned int val = checkOriginalData[i]._value;
-        unsigned int prevVal = checkOriginalData[i - 1]._value;
-
-        if (val == 0xffffffff)
-        {
-            // this was extra data that was padded on
-            continue;
-        }
+    // Note: Only the demo's OriginalData structure is known here.  A user-provided structure is 
+    // only known to the user.
+    long long durationDataVerification = 0;
+    if (_verifyDemoData)
+    {
+        start = high_resolution_clock::now();
+        unsigned int startingIndex = 0;
+        std::vector<OriginalData> checkOriginalData(numItems);
+        unsigned int bufferSizeBytes = checkOriginalData.size() * sizeof(OriginalData);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _originalDataSsbo->BufferId());
+        void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, startingIndex, bufferSizeBytes, GL_MAP_READ_BIT);
+        memcpy(checkOriginalData.data(), bufferPtr, bufferSizeBytes);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-        // the original data is 0 - N-1, 1 value at a time, so it's ok to hard code 
-        if (val < prevVal)
+        // check
+        for (unsigned int i = 1; i < checkOriginalData.size(); i++)
         {
-            printf("value %u at index %u is >= previous value %u and index %u\n", val, i, prevVal, i - 1);
+            unsigned int val = checkOriginalData[i]._value;
+            unsigned int prevVal = checkOriginalData[i - 1]._value;
+
+            if (val == 0xffffffff)
+            {
+                // this was extra data that was padded on
+                continue;
+            }
+
+            // the original data is 0 - N-1, 1 value at a time, so it's ok to hard code 
+            if (val < prevVal)
+            {
+                printf("value %u at index %u is >= previous value %u and index %u\n", val, i, prevVal, i - 1);
+            }
         }
+
+        end = high_resolution_clock::now();
+        durationDataVerification = duration_cast<microseconds>(end - start).count();
     }
 
-    end = high_resolution_clock::now();
-    durationDataVerification = duration_cast<microseconds>(end - start).count();
+    cout << "sorted " << numItems << " items" << endl;
 
     // write the results to stdout and to a text file so that I can dump them into an Excel spreadsheet
     std::ofstream outFile("durations.txt");
     if (outFile.is_open())
     {
-        long long totalParallelSortTime = duration_cast<microseconds>(parallelSortEnd - parallelSortStart).count();
-        cout << "total sort time: " << totalParallelSortTime << "\tmicroseconds" << endl;
-        outFile << "total sort time: " << totalParallelSortTime << "\tmicroseconds" << endl;
+        cout << "total sort time: " << totalSortTime << "\tmicroseconds" << endl;
+        outFile << "total sort time: " << totalSortTime << "\tmicroseconds" << endl;
 
-        cout << "original data to intermediate data: " << durationOriginalDataToIntermediateData << "\tmicroseconds" << endl;
-        outFile << "original data to intermediate data: " << durationOriginalDataToIntermediateData << "\tmicroseconds" << endl;
+        cout << "original data to intermediate data: " << _durationOriginalDataToIntermediateData << "\tmicroseconds" << endl;
+        outFile << "original data to intermediate data: " << _durationOriginalDataToIntermediateData << "\tmicroseconds" << endl;
         
-        cout << "duration sort original data into copy buffer: " << durationSortOriginalData << "\tmicroseconds" << endl;
-        outFile << "duration sort original data into copy buffer: " << durationSortOriginalData << "\tmicroseconds" << endl;
+        cout << "duration sort original data into copy buffer: " << _durationSortOriginalData << "\tmicroseconds" << endl;
+        outFile << "duration sort original data into copy buffer: " << _durationSortOriginalData << "\tmicroseconds" << endl;
 
-        cout << "duration copy sorted original data: " << durationCopySortedOriginalData << "\tmicroseconds" << endl;
-        outFile << "duration copy sorted original data: " << durationCopySortedOriginalData << "\tmicroseconds" << endl;
+        cout << "duration copy sorted original data: " << _durationCopySortedOriginalData << "\tmicroseconds" << endl;
+        outFile << "duration copy sorted original data: " << _durationCopySortedOriginalData << "\tmicroseconds" << endl;
 
         cout << "verifying data: " << durationDataVerification << "\tmicroseconds" << endl;
         outFile << "verifying data: " << durationDataVerification << "\tmicroseconds" << endl;
 
-        cout << "getting bits for prefix scan:" << endl;
-        outFile << "getting bits for prefix scan:" << endl;
-        for (size_t i = 0; i < durationsGetBitForPrefixScan.size(); i++)
+        cout << "incremental sort check and repair: " << _durationIncrementalSort << "\tmicroseconds" << endl;
+        outFile << "incremental sort check and repair: " << _durationIncrementalSort << "\tmicroseconds" << endl;
+
+        cout << "planning sort passes: " << _durationPlanSortPasses << "\tmicroseconds" << endl;
+        outFile << "planning sort passes: " << _durationPlanSortPasses << "\tmicroseconds" << endl;
+
+        // Note: The sort is over, so it doesn't matter that this makes the CPU wait.
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        unsigned int numPassesRun = _sortPassesSsbo->GetNumPassesRun();
+        cout << "passes run: " << numPassesRun << " of " << _numPasses << endl;
+        outFile << "passes run: " << numPassesRun << " of " << _numPasses << endl;
+
+        if (!_useChainedScan)
         {
-            cout << i << "\t" << durationsUseProgramGetBitForPrefixScan[i] << "\t" << durationsGetBitForPrefixScan[i] << "\tmicroseconds" << endl;
-            outFile << i << "\t" << durationsUseProgramGetBitForPrefixScan[i] << "\t" << durationsGetBitForPrefixScan[i] << "\tmicroseconds" << endl;
+            cout << "getting digit counts for prefix scan:" << endl;
+            outFile << "getting digit counts for prefix scan:" << endl;
+            for (size_t i = 0; i < _durationsGetDigitCountsForPrefixScan.size(); i++)
+            {
+                cout << i << "\t" << _durationsGetDigitCountsForPrefixScan[i] << "\tmicroseconds" << endl;
+                outFile << i << "\t" << _durationsGetDigitCountsForPrefixScan[i] << "\tmicroseconds" << endl;
+            }
+            cout << endl;
+            outFile << endl;
+
+            cout << "times for prefix scan over all data:" << endl;
+            outFile << "times for prefix scan over all data:" << endl;
+            for (size_t i = 0; i < _durationsPrefixScanAll.size(); i++)
+            {
+                cout << i << "\t" << _durationsPrefixScanAll[i] << "\tmicroseconds" << endl;
+                outFile << i << "\t" << _durationsPrefixScanAll[i] << "\tmicroseconds" << endl;
+            }
+            cout << endl;
+            outFile << endl;
+
+            cout << "times for prefix scan over work group sums:" << endl;
+            outFile << "times for prefix scan over work group sums:" << endl;
+            for (size_t i = 0; i < _durationsPrefixScanWorkGroupSums.size(); i++)
+            {
+                cout << i << "\t" << _durationsPrefixScanWorkGroupSums[i] << "\tmicroseconds" << endl;
+                outFile << i << "\t" << _durationsPrefixScanWorkGroupSums[i] << "\tmicroseconds" << endl;
+            }
+            cout << endl;
+            outFile << endl;
         }
-        cout << endl;
-        outFile << endl;
 
-        cout << "times for prefix scan over all data:" << endl;
-        outFile << "times for prefix scan over all data:" << endl;
-        for (size_t i = 0; i < durationsPrefixScanAll.size(); i++)
+        cout << "times for sorting intermediate data:" << endl;
+        outFile << "times for sorting intermediate data:" << endl;
+        for (size_t i = 0; i < _durationsSortIntermediateData.size(); i++)
         {
-            cout << i << "\t" << durationsUseProgramPrefixScan[i] << "\t" << durationsPrefixScanAll[i] << "\tmicroseconds" << endl;
-            outFile << i << "\t" << durationsUseProgramPrefixScan[i] << "\t" << durationsPrefixScanAll[i] << "\tmicroseconds" << endl;
+            cout << i << "\t" << _durationsSortIntermediateData[i] << "\tmicroseconds" << endl;
+            outFile << i << "\t" << _durationsSortIntermediateData[i] << "\tmicroseconds" << endl;
         }
         cout << endl;
         outFile << endl;
 
-        cout << "times for prefix scan over work group sums:" << endl;
-        outFile << "times for prefix scan over work group sums:" << endl;
-        for (size_t i = 0; i < durationsPrefixScanWorkGroupSums.size(); i++)
+        // the profiler's averages are over every sort since it was enabled or reset
+        // Note: The diagnostics waited for the GPU to finish this sort, so its timestamps can 
+        // be read now instead of at the next sort.
+        if (_gpuProfiler != nullptr)
         {
-            cout << i << "\t" << durationsPrefixScanWorkGroupSums[i] << "\tmicroseconds" << endl;
-            outFile << i << "\t" << durationsPrefixScanWorkGroupSums[i] << "\tmicroseconds" << endl;
+            _gpuProfiler->ReadAvailableFrames();
+            cout << "GPU profile, average of " << _gpuProfiler->NumFramesRead() << " sorts (" << 
+                _gpuProfiler->NumFramesDropped() << " dropped):" << endl;
+            outFile << "GPU profile, average of " << _gpuProfiler->NumFramesRead() << " sorts (" << 
+                _gpuProfiler->NumFramesDropped() << " dropped):" << endl;
+            for (unsigned int stage = 0; stage < _gpuProfiler->NumStages(); stage++)
+            {
+                double averageMicroseconds = _gpuProfiler->AverageStageMilliseconds(stage) * 1000.0;
+                cout << _gpuProfiler->StageName(stage) << ": " << averageMicroseconds << "\tmicroseconds" << endl;
+                outFile << _gpuProfiler->StageName(stage) << ": " << averageMicroseconds << "\tmicroseconds" << endl;
+            }
+            cout << endl;
+            outFile << endl;
         }
-        cout << endl;
-        outFile << endl;
+    }
+    outFile.close();
+}
 
-        cout << "times for sorting intermediate data:" << endl;
-        outFile << "times for sorting intermediate data:" << endl;
-        for (size_t i = 0; i < durationsSortIntermediateData.size(); i++)
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the intermediate data, which has the sorted keys and original indices after Sort().
+    Which half of it they are in is only known on the GPU (see SortPasses() and 
+    SortedIntermediateData.comp).
+
+    Note: The intermediate data is reallocated when a sort needs more room than it has (see 
+    PrepareToSort(...)), so get it again after each Sort(...) instead of holding onto it.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+const IntermediateDataSsbo::SHARED_PTR &ParallelSort::SortedIntermediateData() const
+{
+    return _intermediateDataSsbo;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the buffer that says which half of the intermediate data the sorted items are in 
+    (SortPassesBuffer::FinalIntermediateBufferReadOffset).
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+const SortPassesSsbo::SHARED_PTR &ParallelSort::SortPasses() const
+{
+    return _sortPassesSsbo;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Dispatches ParallelPrefixScan.comp over one level of PrefixScanBuffer::AllPrefixSums.  
+    Whether that scans the level or adds the level above to it depends on the 
+    UNIFORM_LOCATION_PREFIX_SCAN_ADD_GROUP_SUMS uniform, which the caller is expected to have 
+    set already (as well as the program).
+
+    Either way, the prefix scan shader works on PREFIX_SCAN_ITEMS_PER_THREAD items per thread, 
+    so it takes 1 work group per ITEMS_PER_WORK_GROUP items in the level that the sort uses.  
+    The levels were laid out for the most sort tiles that there is room for, but a sort with 
+    fewer tiles only uses the beginning of each level.  The entries after those may have junk 
+    from a bigger sort, but a prefix sum is only affected by the entries before it (see the 
+    PrefixSumSsbo constructor), so they are left alone.
+Parameters: 
+    level           See PrefixScanBuffer.comp.
+    numDigitCounts  How many entries of level 0 the sort uses (1 per digit value per sort tile).
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::DispatchPrefixScanLevel(unsigned int level, unsigned int numDigitCounts) const
+{
+    // each level has 1 entry per work group of the level below it
+    unsigned int numEntries = numDigitCounts;
+    for (unsigned int levelBelow = 0; levelBelow < level; levelBelow++)
+    {
+        numEntries = (numEntries + ITEMS_PER_WORK_GROUP - 1) / ITEMS_PER_WORK_GROUP;
+    }
+    unsigned int numWorkGroupsX = (numEntries + ITEMS_PER_WORK_GROUP - 1) / ITEMS_PER_WORK_GROUP;
+    numWorkGroupsX = (numWorkGroupsX == 0) ? 1 : numWorkGroupsX;
+
+    glUniform1ui(UNIFORM_LOCATION_PREFIX_SCAN_LEVEL_OFFSET, _prefixSumSsbo->LevelOffset(level));
+    glUniform1ui(UNIFORM_LOCATION_PREFIX_SCAN_GROUP_SUMS_OFFSET, _prefixSumSsbo->LevelOffset(level + 1));
+    glDispatchCompute(numWorkGroupsX, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Gets the number of sort tiles (1 work group each) that it takes to sort some number of 
+    items, laid out as a 2D grid of work groups.
+
+    There is a limit on how many work groups can be dispatched in X, so if there are more 
+    tiles than that, then they are spread out over Y as well.  The shaders calculate the tile 
+    index as if the 2D grid of work groups was a 1D array, so the grid must be full.  The tile 
+    count is padded up to a multiple of the Y dimension so that every row has the same number 
+    of tiles (the extra tiles are padding like any other).
+Parameters: 
+    numItems        Self-explanatory.
+    numWorkGroupsX  Set to the grid's size.
+    numWorkGroupsY
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::GetSortTileGrid(unsigned int numItems, unsigned int &numWorkGroupsX, unsigned int &numWorkGroupsY) const
+{
+    // the digit counting and the digit scatter work on whole sort tiles, so pad the items out 
+    // to a multiple of the tile size (see the explanation in the PrefixSumSsbo constructor for 
+    // why the padding is harmless)
+    unsigned int numSortTiles = numItems / PARALLEL_SORT_ITEMS_PER_SORT_TILE;
+    numSortTiles += (numItems % PARALLEL_SORT_ITEMS_PER_SORT_TILE == 0) ? 0 : 1;
+    numSortTiles = (numSortTiles == 0) ? 1 : numSortTiles;
+
+    numWorkGroupsY = numSortTiles / PARALLEL_SORT_MAX_WORK_GROUPS_X;
+    numWorkGroupsY += (numSortTiles % PARALLEL_SORT_MAX_WORK_GROUPS_X == 0) ? 0 : 1;
+    numWorkGroupsX = numSortTiles / numWorkGroupsY;
+    numWorkGroupsX += (numSortTiles % numWorkGroupsY == 0) ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Sets up the work group counts, the buffers, and the uniforms for a sort of numItems items.  
+    Nothing is done for what hasn't changed since the last sort.
+
+    If the buffers that are sized by the number of sort tiles are too small, then they are 
+    reallocated with at least twice as much room (up to the most that the original data can 
+    need), so a number of items that creeps up from sort to sort only reallocates a few times.  
+    They never shrink.
+Parameters: 
+    numItems    Self-explanatory.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::PrepareToSort(unsigned int numItems)
+{
+    unsigned int numWorkGroupsX = 0;
+    unsigned int numWorkGroupsY = 0;
+    GetSortTileGrid(numItems, numWorkGroupsX, numWorkGroupsY);
+    unsigned int numSortTiles = numWorkGroupsX * numWorkGroupsY;
+    if (numSortTiles > _numSortTilesCapacity)
+    {
+        unsigned int maxNumWorkGroupsX = 0;
+        unsigned int maxNumWorkGroupsY = 0;
+        GetSortTileGrid(_originalDataSsbo->NumItems(), maxNumWorkGroupsX, maxNumWorkGroupsY);
+        unsigned int maxNumSortTiles = maxNumWorkGroupsX * maxNumWorkGroupsY;
+
+        unsigned int numSortTilesCapacity = 2 * _numSortTilesCapacity;
+        numSortTilesCapacity = (numSortTilesCapacity > maxNumSortTiles) ? maxNumSortTiles : numSortTilesCapacity;
+        numSortTilesCapacity = (numSortTilesCapacity < numSortTiles) ? numSortTiles : numSortTilesCapacity;
+        AllocateSortBuffers(numSortTilesCapacity);
+    }
+
+    if (numWorkGroupsX != _numWorkGroupsX || numWorkGroupsY != _numWorkGroupsY)
+    {
+        // the passes' and the repair's work group counts are made on the GPU
+        _numWorkGroupsX = numWorkGroupsX;
+        _numWorkGroupsY = numWorkGroupsY;
+        _sortPassesSsbo->SetNumWorkGroups(_numWorkGroupsX, _numWorkGroupsY);
+        _sortPassesSsbo->ConfigureConstantUniforms(_planSortPassesProgramId);
+        if (_incrementalSort)
         {
-            cout << i << "\t" << durationsUseProgramSortIntermediateData[i] << "\t" << durationsSortIntermediateData[i] << "\tmicroseconds" << endl;
-            outFile << i << "\t" << durationsUseProgramSortIntermediateData[i] << "\t" << durationsSortIntermediateData[i] << "\tmicroseconds" << endl;
+            _sortPassesSsbo->ConfigureConstantUniforms(_planIncrementalSortProgramId);
         }
-        cout << endl;
-        outFile << endl;
     }
-    outFile.close();
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-    glUseProgram(0);
+    if (numItems != _numItemsToSort)
+    {
+        // the shaders that check an item index against the size of the original data only 
+        // look at the items that are sorted
+        _numItemsToSort = numItems;
+        glUseProgram(_originalDataToIntermediateDataProgramId);
+        glUniform1ui(UNIFORM_LOCATION_ORIGINAL_DATA_BUFFER_SIZE, _numItemsToSort);
+        if (_computePositionBoundsProgramId != 0)
+        {
+            glUseProgram(_computePositionBoundsProgramId);
+            glUniform1ui(UNIFORM_LOCATION_ORIGINAL_DATA_BUFFER_SIZE, _numItemsToSort);
+        }
+        if (_sortOriginalDataProgramId != 0)
+        {
+            glUseProgram(_sortOriginalDataProgramId);
+            glUniform1ui(UNIFORM_LOCATION_ORIGINAL_DATA_BUFFER_SIZE, _numItemsToSort);
+        }
+        if (_copySortedOriginalDataProgramId != 0)
+        {
+            glUseProgram(_copySortedOriginalDataProgramId);
+            glUniform1ui(UNIFORM_LOCATION_ORIGINAL_DATA_BUFFER_SIZE, _numItemsToSort);
+        }
+        glUseProgram(0);
+    }
+
+    // the gather into the sorted copy is 1 thread per item, or per word of each item if it is 
+    // the wide gather
+    // Note: The gather checks the item index against the number of items, so this grid 
+    // doesn't have to be full.
+    unsigned int lastSortOriginalDataNumWorkGroupsX = _sortOriginalDataNumWorkGroupsX;
+    unsigned int lastSortOriginalDataNumWorkGroupsY = _sortOriginalDataNumWorkGroupsY;
+    _sortOriginalDataNumWorkGroupsX = _numWorkGroupsX;
+    _sortOriginalDataNumWorkGroupsY = _numWorkGroupsY;
+    if (_sortOriginalDataWordsPerItem > 1)
+    {
+        unsigned long long numWords = static_cast<unsigned long long>(numItems) * _sortOriginalDataWordsPerItem;
+        unsigned int numGatherWorkGroups = static_cast<unsigned int>((numWords + PARALLEL_SORT_WORK_GROUP_SIZE_X - 1) / PARALLEL_SORT_WORK_GROUP_SIZE_X);
+        numGatherWorkGroups = (numGatherWorkGroups == 0) ? 1 : numGatherWorkGroups;
+        _sortOriginalDataNumWorkGroupsY = (numGatherWorkGroups + PARALLEL_SORT_MAX_WORK_GROUPS_X - 1) / PARALLEL_SORT_MAX_WORK_GROUPS_X;
+        _sortOriginalDataNumWorkGroupsX = (numGatherWorkGroups + _sortOriginalDataNumWorkGroupsY - 1) / _sortOriginalDataNumWorkGroupsY;
+    }
 
+    // an incremental sort's gather and copy back run with whatever PlanIncrementalSort.comp 
+    // says, which is this grid or nothing
+    bool gatherGridChanged = _sortOriginalDataNumWorkGroupsX != lastSortOriginalDataNumWorkGroupsX || 
+        _sortOriginalDataNumWorkGroupsY != lastSortOriginalDataNumWorkGroupsY;
+    if (_copySortedOriginalDataProgramId != 0 && gatherGridChanged)
+    {
+        glUseProgram(_planIncrementalSortProgramId);
+        glUniform1ui(UNIFORM_LOCATION_GATHER_NUM_WORK_GROUPS_X, _sortOriginalDataNumWorkGroupsX);
+        glUniform1ui(UNIFORM_LOCATION_GATHER_NUM_WORK_GROUPS_Y, _sortOriginalDataNumWorkGroupsY);
+        glUseProgram(0);
+    }
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds this sort's buffers to their binding points (see SsboBufferBindings.comp), which 
+    another sort or select may have bound its own buffers to since this sort's last Sort(...).
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::BindBuffers() const
+{
+    _originalDataSsbo->Bind();
+    if (_originalDataCopySsbo != nullptr)
+    {
+        _originalDataCopySsbo->Bind();
+    }
+    if (_segmentOffsetsSsbo != nullptr)
+    {
+        _segmentOffsetsSsbo->Bind();
+    }
+    _intermediateDataSsbo->Bind();
+    _prefixSumSsbo->Bind();
+    _prefixScanStatusSsbo->Bind();
+    _sortPassesSsbo->Bind();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    (Re)allocates the buffers that are sized by the number of sort tiles and gives their sizes 
+    to the shaders that use them.  The old buffers (if any) are deleted, and the new ones are 
+    bound to the same binding points.
+Parameters: 
+    numSortTiles    How many sort tiles there is room for.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSort::AllocateSortBuffers(unsigned int numSortTiles)
+{
+    _numSortTilesCapacity = numSortTiles;
+
+    // every sort tile has a count for every possible digit value, and those counts are what 
+    // get scanned
+    unsigned int numDigitCounts = numSortTiles * PARALLEL_SORT_NUM_DIGIT_VALUES;
+    _prefixSumSsbo = std::make_unique<PrefixSumSsbo>(numDigitCounts);
+
+    // the chained scan needs a status for every digit value of every sort tile
+    _prefixScanStatusSsbo = std::make_unique<PrefixScanStatusSsbo>(numSortTiles, _keyWidthBits);
+
+    // the PrefixScanBuffer is used in three shaders
+    _prefixSumSsbo->ConfigureConstantUniforms(_getDigitCountsForPrefixScansProgramId);
+    _prefixSumSsbo->ConfigureConstantUniforms(_parallelPrefixScanProgramId);
+    _prefixSumSsbo->ConfigureConstantUniforms(_sortIntermediateDataProgramId);
+
+    unsigned int numIntermediateItems = numSortTiles * PARALLEL_SORT_ITEMS_PER_SORT_TILE;
+    _intermediateDataSsbo = std::make_unique<IntermediateDataSsbo>(numIntermediateItems, 
+        PARALLEL_SORT_NUM_KEY_WORDS_FOR_KEY_WIDTH(_keyWidthBits));
+    _intermediateDataSsbo->ConfigureConstantUniforms(_originalDataToIntermediateDataProgramId);
+    _intermediateDataSsbo->ConfigureConstantUniforms(_planSortPassesProgramId);
+    _intermediateDataSsbo->ConfigureConstantUniforms(_getDigitCountsForPrefixScansProgramId);
+    _intermediateDataSsbo->ConfigureConstantUniforms(_sortIntermediateDataProgramId);
+    _intermediateDataSsbo->ConfigureConstantUniforms(_sortIntermediateDataChainedProgramId);
+}
@@ -0,0 +1,55 @@
+#include "Include/ComputeControllers/ParallelSortOptions.h"
+
+#include <stdio.h>
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Replaces a key width or a key type that the shaders can't handle with the default (32-bit 
+    unsigned integer keys) and says so on stderr.  Each class that is made with these options 
+    checks them this way before it makes its shaders.
+Parameters:
+    userName    The class that is checking them (ex: "ParallelSelect"), for the messages.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void ParallelSortOptions::ValidateKey(const std::string &userName)
+{
+    if (_keyWidthBits == 0 || _keyWidthBits > PARALLEL_SORT_MAX_KEY_WIDTH_BITS)
+    {
+        fprintf(stderr, "%s: key width of %u bits is not supported; using 32 bits instead\n", 
+            userName.c_str(), _keyWidthBits);
+        _keyWidthBits = 32;
+    }
+
+    if (_keyType != PARALLEL_SORT_KEY_TYPE_UNSIGNED_INT &&
+        _keyType != PARALLEL_SORT_KEY_TYPE_SIGNED_INT &&
+        _keyType != PARALLEL_SORT_KEY_TYPE_FLOAT)
+    {
+        fprintf(stderr, "%s: unknown key type %u; using unsigned integer keys instead\n", 
+            userName.c_str(), _keyType);
+        _keyType = PARALLEL_SORT_KEY_TYPE_UNSIGNED_INT;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The key width has to be known before ParallelSortConstants.comp in every shader that uses 
+    keys because the buffers' layouts depend on it, and the key type, the order, and the 
+    segment bits go along with it.  This makes those #defines for the shader's string.
+Parameters:
+    segmentBits     How many bits the segment number takes above the key (see 
+                    ParallelSortConstants.comp).  They are added to the key width.
+Returns:    
+    A string of #defines to go right after Version.comp.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+std::string ParallelSortOptions::KeyDefinesGlsl(unsigned int segmentBits) const
+{
+    return 
+        "#define PARALLEL_SORT_KEY_WIDTH_BITS " + std::to_string(_keyWidthBits + segmentBits) + "\n" +
+        "#define PARALLEL_SORT_KEY_TYPE " + std::to_string(_keyType) + "\n" +
+        "#define PARALLEL_SORT_KEY_DESCENDING " + (_descending ? "1" : "0") + "\n" +
+        "#define PARALLEL_SORT_SEGMENT_BITS " + std::to_string(segmentBits) + "\n" +
+        "#define PARALLEL_SORT_INCREMENTAL " + (_incrementalSort ? "1" : "0") + "\n";
+}
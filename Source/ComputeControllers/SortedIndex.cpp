@@ -0,0 +1,255 @@
+#include "Include/ComputeControllers/SortedIndex.h"
+
+#include "Shaders/ShaderStorage.h"
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+#include "Shaders/ParallelSort/ParallelSortConstants.comp"
+#include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
+#include "Shaders/ComputeHeaders/UniformLocations.comp"
+
+#include <stdio.h>
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Generates the merge compute shader, makes the ParallelSort for the delta, and allocates 
+    the sorted run.  Buffer sizes depend on the size of the indexed data and of the delta.  
+    They are expected to remain constant after class creation.
+Parameters:
+    indexedData     The items that have been indexed.  The delta's items are copied to the end 
+                    of them when they are merged, so it needs room for every item that will 
+                    ever be indexed, and its NumItems() is the most items that the index can 
+                    have.
+    deltaData       Where new items are written before they are indexed.  Its NumItems() is 
+                    how many items are merged at a time.  Must hold the same structure as the 
+                    indexed data.
+    options         See ParallelSortOptions.h.  The key width, the key type, and descending 
+                    apply to the index.  The chained scan and subgroups apply to the delta's 
+                    sort, which only ever sorts the intermediate data of the whole delta, so 
+                    the rest don't apply.
+    originalDataStructureGlsl
+    getSortKeyGlsl  The same as ParallelSort's.  TypedParallelSort's generated strings work 
+                    here too.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+SortedIndex::SortedIndex(const OriginalDataSsbo::SHARED_PTR &indexedData, const OriginalDataSsbo::SHARED_PTR &deltaData, 
+    const ParallelSortOptions &options, const std::string &originalDataStructureGlsl, 
+    const std::string &getSortKeyGlsl) :
+    _mergeSortedDeltaProgramId(0),
+    _deltaSort(nullptr),
+    _sortedIndexSsbo(nullptr),
+    _indexedDataSsbo(indexedData),
+    _deltaDataSsbo(deltaData),
+    _sortedIndexReadOffset(0),
+    _numIndexedItems(0),
+    _numDeltaItems(0)
+{
+    ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+    std::string shaderKey;
+
+    ParallelSortOptions keyOptions(options);
+    keyOptions.ValidateKey("SortedIndex");
+
+    if (indexedData->ItemSizeBytes() != deltaData->ItemSizeBytes())
+    {
+        fprintf(stderr, "SortedIndex: indexed items are %u bytes, but delta items are %u bytes; nothing will be merged\n", 
+            indexedData->ItemSizeBytes(), deltaData->ItemSizeBytes());
+    }
+
+    // the delta is sorted like any other data, except that only its intermediate data is 
+    // sorted because the merge only needs the keys and the indices
+    ParallelSortOptions deltaSortOptions;
+    deltaSortOptions._keyWidthBits = keyOptions._keyWidthBits;
+    deltaSortOptions._keyType = keyOptions._keyType;
+    deltaSortOptions._descending = keyOptions._descending;
+    deltaSortOptions._useChainedScan = options._useChainedScan;
+    deltaSortOptions._useSubgroups = options._useSubgroups;
+    deltaSortOptions._sortOriginalData = false;
+    _deltaSort = std::make_unique<ParallelSort>(deltaData, deltaSortOptions, originalDataStructureGlsl, getSortKeyGlsl);
+
+    std::string keyDefines = keyOptions.KeyDefinesGlsl();
+
+    // merge the sorted delta into the sorted run
+    shaderKey = shaderStorageRef.NewUniqueProgramKey("merge sorted delta");
+    shaderStorageRef.NewCompositeShader(shaderKey);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/Version.comp");
+    shaderStorageRef.AddPartialShaderString(shaderKey, keyDefines);
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/SsboBufferBindings.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ComputeHeaders/UniformLocations.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/ParallelSortConstants.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortKey.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/IntermediateSortBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortPassesBuffer.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/SortedIndexBuffers.comp");
+    shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ParallelSort/MergeSortedDelta.comp");
+    shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+    _mergeSortedDeltaProgramId = shaderStorageRef.LinkShader(shaderKey);
+    _programKeys.push_back(shaderKey);
+
+    _sortedIndexSsbo = std::make_unique<SortedIndexSsbo>(indexedData->NumItems(), 
+        PARALLEL_SORT_NUM_KEY_WORDS_FOR_KEY_WIDTH(keyOptions._keyWidthBits));
+
+    // the delta's buffer was the last one bound to the original data's binding point, but 
+    // shaders that use the index want the indexed data
+    _indexedDataSsbo->Bind();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Deletes the merge program.  The delta's ParallelSort deletes its own.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+SortedIndex::~SortedIndex()
+{
+    ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+    for (size_t keyIndex = 0; keyIndex < _programKeys.size(); keyIndex++)
+    {
+        shaderStorageRef.DeleteShader(_programKeys[keyIndex]);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Tells the index that the next numItems items of the delta have been written (the caller 
+    writes them to the delta's buffer first, starting at NumDeltaItems()).  If that fills the 
+    delta, then it is merged into the index.
+
+    Note: If items were written with a shader, then the caller must issue a 
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT) before this.
+Parameters:
+    numItems    How many items were written to the delta.
+Returns:    
+    How many of them were added.  It is fewer than numItems if the delta or the indexed data 
+    doesn't have room for all of them.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortedIndex::AddDeltaItems(unsigned int numItems)
+{
+    unsigned int deltaRoom = _deltaDataSsbo->NumItems() - _numDeltaItems;
+    unsigned int indexRoom = _indexedDataSsbo->NumItems() - _numIndexedItems - _numDeltaItems;
+    unsigned int numAdded = (numItems < deltaRoom) ? numItems : deltaRoom;
+    numAdded = (numAdded < indexRoom) ? numAdded : indexRoom;
+    if (numAdded < numItems)
+    {
+        fprintf(stderr, "SortedIndex: only %u of %u items could be added to the delta\n", numAdded, numItems);
+    }
+
+    _numDeltaItems += numAdded;
+    if (_numDeltaItems > 0 && _numDeltaItems == _deltaDataSsbo->NumItems())
+    {
+        MergeDelta();
+    }
+
+    return numAdded;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for how many items are in the sorted run.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortedIndex::NumIndexedItems() const
+{
+    return _numIndexedItems;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for how many items are waiting in the delta to be merged.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortedIndex::NumDeltaItems() const
+{
+    return _numDeltaItems;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the sorted run.  The first NumIndexedItems() of its keys and indices are bound to 
+    their dedicated binding points (see SortedIndexBuffers.comp).
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+const SortedIndexSsbo::SHARED_PTR &SortedIndex::SortedIndexData() const
+{
+    return _sortedIndexSsbo;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Sorts the delta, copies its items to the end of the indexed data, and merges the sorted 
+    delta into the sorted run, from one half of the SortedIndexSsbo to the other.  Nothing is 
+    read back to the CPU.
+
+    This is called when the delta fills up, but it can be called whenever the items in the 
+    delta need to be in the index (ex: at the end of a frame).  Only the items in the delta are 
+    sorted, so merging a delta that is only partly full doesn't cost a sort of all of it.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SortedIndex::MergeDelta()
+{
+    if (_numDeltaItems == 0)
+    {
+        return;
+    }
+
+    unsigned int numMergedItems = _numIndexedItems + _numDeltaItems;
+    unsigned int itemSizeBytes = _indexedDataSsbo->ItemSizeBytes();
+    if (numMergedItems > _indexedDataSsbo->NumItems() || itemSizeBytes != _deltaDataSsbo->ItemSizeBytes())
+    {
+        fprintf(stderr, "SortedIndex: can't merge %u delta items into %u indexed items\n", _numDeltaItems, _numIndexedItems);
+        return;
+    }
+
+    // Note: The sort binds the delta to the original data's binding point and leaves its 
+    // sorted intermediate data bound for the merge.
+    _deltaSort->Sort(_numDeltaItems);
+
+    // the indices in the sorted delta are relative to the delta, so the merge adds the number 
+    // of indexed items to them, which is where they are copied to
+    glBindBuffer(GL_COPY_READ_BUFFER, _deltaDataSsbo->BufferId());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _indexedDataSsbo->BufferId());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 
+        0, _numIndexedItems * itemSizeBytes, _numDeltaItems * itemSizeBytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    unsigned int readOffset = _sortedIndexReadOffset;
+    unsigned int writeOffset = (readOffset == 0) ? _sortedIndexSsbo->NumItems() : 0;
+    _sortedIndexSsbo->BindBothRuns();
+
+    // each thread makes SORTED_INDEX_MERGE_ITEMS_PER_THREAD merged items
+    unsigned int numThreads = (numMergedItems + SORTED_INDEX_MERGE_ITEMS_PER_THREAD - 1) / SORTED_INDEX_MERGE_ITEMS_PER_THREAD;
+    unsigned int numWorkGroups = (numThreads + PARALLEL_SORT_WORK_GROUP_SIZE_X - 1) / PARALLEL_SORT_WORK_GROUP_SIZE_X;
+    unsigned int numWorkGroupsY = (numWorkGroups + PARALLEL_SORT_MAX_WORK_GROUPS_X - 1) / PARALLEL_SORT_MAX_WORK_GROUPS_X;
+    unsigned int numWorkGroupsX = (numWorkGroups + numWorkGroupsY - 1) / numWorkGroupsY;
+    glUseProgram(_mergeSortedDeltaProgramId);
+    glUniform1ui(UNIFORM_LOCATION_MERGE_NUM_INDEXED_ITEMS, _numIndexedItems);
+    glUniform1ui(UNIFORM_LOCATION_MERGE_NUM_DELTA_ITEMS, _numDeltaItems);
+    glUniform1ui(UNIFORM_LOCATION_MERGE_READ_OFFSET, readOffset);
+    glUniform1ui(UNIFORM_LOCATION_MERGE_WRITE_OFFSET, writeOffset);
+    glDispatchCompute(numWorkGroupsX, numWorkGroupsY, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glUseProgram(0);
+
+    // the merged run is the sorted run now
+    _sortedIndexReadOffset = writeOffset;
+    _sortedIndexSsbo->BindRun(_sortedIndexReadOffset);
+    _indexedDataSsbo->Bind();
+
+    _numIndexedItems = numMergedItems;
+    _numDeltaItems = 0;
+}
@@ -0,0 +1,320 @@
+#include "Include/GpuProfiler.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+#include <stdio.h>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Gives members initial values and makes all the query objects up front so that profiling a
+    frame doesn't allocate anything.
+Parameters:
+    stageNames      1 per stage, in the order that the stages run.  Only for reporting.
+    numFramesInRing How many frames can be waiting on the GPU before the oldest is dropped.
+                    Must be at least 2 (the frame being timestamped and the one before it).
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+GpuProfiler::GpuProfiler(const std::vector<std::string> &stageNames, unsigned int numFramesInRing) :
+    _stageNames(stageNames),
+    _numStages(static_cast<unsigned int>(stageNames.size())),
+    _numFramesInRing((numFramesInRing < 2) ? 2 : numFramesInRing),
+    _currentFrameSlot(0),
+    _oldestFrameSlot(0),
+    _inFrame(false),
+    _numFramesRead(0),
+    _numFramesDropped(0)
+{
+    _queryIds.resize(_numFramesInRing * (_numStages + 1));
+    glGenQueries(static_cast<GLsizei>(_queryIds.size()), _queryIds.data());
+
+    _stageTimestamped.resize(_numFramesInRing * _numStages);
+    _framePending.resize(_numFramesInRing);
+    _lastFrameStageTimes.resize(_numStages);
+    _totalStageTimes.resize(_numStages);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Deletes the query objects.  Any results that haven't been read are thrown away.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+GpuProfiler::~GpuProfiler()
+{
+    glDeleteQueries(static_cast<GLsizei>(_queryIds.size()), _queryIds.data());
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Reads the results of any earlier frames that the GPU has finished, then takes the next
+    frame slot in the ring and timestamps the start of the frame.
+
+    If the GPU still hasn't finished the frame that was in that slot, then that frame is
+    dropped (see NumFramesDropped()).
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void GpuProfiler::BeginFrame()
+{
+    if (_inFrame)
+    {
+        fprintf(stderr, "GpuProfiler: BeginFrame() called twice without EndFrame()\n");
+        EndFrame();
+    }
+
+    ReadAvailableFrames();
+
+    // the slot after the last frame's
+    // Note: The ring is full if that is the oldest pending frame, so drop it.
+    unsigned int frameSlot = (_currentFrameSlot + 1) % _numFramesInRing;
+    if (_framePending[frameSlot])
+    {
+        _framePending[frameSlot] = 0;
+        _numFramesDropped++;
+        _oldestFrameSlot = (frameSlot + 1) % _numFramesInRing;
+    }
+
+    for (unsigned int stage = 0; stage < _numStages; stage++)
+    {
+        _stageTimestamped[(frameSlot * _numStages) + stage] = 0;
+    }
+
+    _currentFrameSlot = frameSlot;
+    _inFrame = true;
+    glQueryCounter(_queryIds[frameSlot * (_numStages + 1)], GL_TIMESTAMP);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Records the GPU's time at the end of a stage.  The GPU fills it out when it finishes
+    everything before it, so this doesn't wait for anything.  Does nothing outside of a
+    frame.
+Parameters:
+    stage   Index into the stage names that the profiler was made with.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void GpuProfiler::Timestamp(unsigned int stage)
+{
+    if (!_inFrame || stage >= _numStages)
+    {
+        return;
+    }
+
+    _stageTimestamped[(_currentFrameSlot * _numStages) + stage] = 1;
+    glQueryCounter(_queryIds[(_currentFrameSlot * (_numStages + 1)) + stage + 1], GL_TIMESTAMP);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Ends the frame that BeginFrame() started.  Its results are read on a later BeginFrame().
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void GpuProfiler::EndFrame()
+{
+    if (!_inFrame)
+    {
+        return;
+    }
+
+    _framePending[_currentFrameSlot] = 1;
+    _inFrame = false;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Throws away the averages so far and the frames that haven't been read yet (ex: after a 
+    warm-up, whose frames are usually still pending).  A frame that is between BeginFrame() 
+    and EndFrame() is kept.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void GpuProfiler::Reset()
+{
+    for (unsigned int stage = 0; stage < _numStages; stage++)
+    {
+        _totalStageTimes[stage] = 0;
+    }
+    _numFramesRead = 0;
+    _numFramesDropped = 0;
+
+    for (unsigned int frameSlot = 0; frameSlot < _numFramesInRing; frameSlot++)
+    {
+        _framePending[frameSlot] = 0;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for how many stages the profiler was made with.
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int GpuProfiler::NumStages() const
+{
+    return _numStages;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for the name that the stage was given on creation.
+Parameters:
+    stage   Less than NumStages().
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+const std::string &GpuProfiler::StageName(unsigned int stage) const
+{
+    return _stageNames[stage];
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    How long the stage took in the most recent frame that was read.  That is usually a frame
+    or two behind the latest one.
+Parameters:
+    stage   Less than NumStages().
+Returns:
+    See Description.  0 if no frames have been read.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+double GpuProfiler::LastFrameStageMilliseconds(unsigned int stage) const
+{
+    return _lastFrameStageTimes[stage] / 1000000.0;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    How long the stage took on average over the frames that have been read since creation or
+    since Reset().
+Parameters:
+    stage   Less than NumStages().
+Returns:
+    See Description.  0 if no frames have been read.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+double GpuProfiler::AverageStageMilliseconds(unsigned int stage) const
+{
+    if (_numFramesRead == 0)
+    {
+        return 0.0;
+    }
+
+    return (_totalStageTimes[stage] / 1000000.0) / _numFramesRead;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for how many frames' results have been read since creation or since
+    Reset().
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int GpuProfiler::NumFramesRead() const
+{
+    return _numFramesRead;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for how many frames were dropped since creation or since Reset() because
+    the GPU hadn't finished them by the time that the ring came back around to them.  If this
+    keeps going up, then make the ring deeper.
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int GpuProfiler::NumFramesDropped() const
+{
+    return _numFramesDropped;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Reads the pending frames, oldest first, until it gets to one that the GPU hasn't finished.
+    The GPU finishes them in order, so none after that one are finished either.
+
+    BeginFrame() calls this, so the averages are usually a few frames behind.  Call it after 
+    EndFrame() to catch up on frames that are known to be finished (ex: after a glFinish()).
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void GpuProfiler::ReadAvailableFrames()
+{
+    for (unsigned int frameCount = 0; frameCount < _numFramesInRing; frameCount++)
+    {
+        unsigned int frameSlot = _oldestFrameSlot;
+        if (_framePending[frameSlot] && !ReadFrame(frameSlot))
+        {
+            break;
+        }
+
+        _oldestFrameSlot = (frameSlot + 1) % _numFramesInRing;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    If all of a frame's timestamps are available, then this reads them and turns them into
+    each stage's time.
+Parameters:
+    frameSlot   Self-explanatory.
+Returns:
+    True if the frame was read, false if some of its timestamps aren't available yet.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+bool GpuProfiler::ReadFrame(unsigned int frameSlot)
+{
+    // Note: Asking whether a result is available doesn't wait for the GPU.  Check the last
+    // timestamp first because it is the most likely one to not be available yet.
+    const unsigned int *queryIds = &_queryIds[frameSlot * (_numStages + 1)];
+    const unsigned char *stageTimestamped = &_stageTimestamped[frameSlot * _numStages];
+    for (unsigned int queryIndex = _numStages + 1; queryIndex-- > 0;)
+    {
+        if (queryIndex > 0 && !stageTimestamped[queryIndex - 1])
+        {
+            continue;
+        }
+
+        GLuint isAvailable = GL_FALSE;
+        glGetQueryObjectuiv(queryIds[queryIndex], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (isAvailable == GL_FALSE)
+        {
+            return false;
+        }
+    }
+
+    GLuint64 previousTimestamp = 0;
+    glGetQueryObjectui64v(queryIds[0], GL_QUERY_RESULT, &previousTimestamp);
+    for (unsigned int stage = 0; stage < _numStages; stage++)
+    {
+        GLuint64 stageTime = 0;
+        if (stageTimestamped[stage])
+        {
+            GLuint64 timestamp = 0;
+            glGetQueryObjectui64v(queryIds[stage + 1], GL_QUERY_RESULT, &timestamp);
+            stageTime = timestamp - previousTimestamp;
+            previousTimestamp = timestamp;
+        }
+
+        _lastFrameStageTimes[stage] = stageTime;
+        _totalStageTimes[stage] += stageTime;
+    }
+
+    _framePending[frameSlot] = 0;
+    _numFramesRead++;
+    return true;
+}
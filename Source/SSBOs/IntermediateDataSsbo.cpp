@@ -4,8 +4,6 @@
 #include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
 #include "Shaders/ComputeHeaders/UniformLocations.comp"
 
-#include "Include/SSBOs/IntermediateData.h"
-
 #include <vector>
 
 /*------------------------------------------------------------------------------------------------
@@ -14,22 +12,58 @@ Description:
     for the SSBO.
 Parameters: 
     numItems    MUST be the same size as PrefixScanBuffer::PrefixSumsWithinGroup.
+    numKeyWords How many uints each key takes up (see SortKey.comp).
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
-IntermediateDataSsbo::IntermediateDataSsbo(unsigned int numItems) :
+IntermediateDataSsbo::IntermediateDataSsbo(unsigned int numItems, unsigned int numKeyWords) :
     SsboBase(),  // generate buffers
-    _numItems(numItems)
+    _numItems(numItems),
+    _numKeyWords(numKeyWords),
+    _indicesByteOffset(0)
 {
-    std::vector<IntermediateData> v(numItems * 2);
+    // the keys and the indices are each a read/write pair of arrays (see 
+    // IntermediateSortBuffers.comp)
+    unsigned int keysByteSize = numItems * 2 * numKeyWords * sizeof(unsigned int);
+    unsigned int indicesByteSize = numItems * 2 * sizeof(unsigned int);
+
+    // the indices start after the keys, but a range that is bound to a binding point has to 
+    // start on a multiple of the implementation's alignment
+    // Note: numItems is a multiple of the work group size, so in practice the keys' size 
+    // already is one.
+    int offsetAlignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    _indicesByteOffset = 
+        ((keysByteSize + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
 
-    // now bind this new buffer to the dedicated buffer binding location
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INTERMEDIATE_SORT_BUFFERS_BINDING, _bufferId);
+    // the std::vector<...>(...) constructor will set everything to 0
+    std::vector<unsigned int> v((_indicesByteOffset + indicesByteSize) / sizeof(unsigned int));
 
     // and fill it with new data
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(IntermediateData), v.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // now bind each half of this new buffer to its dedicated buffer binding location
+    Bind();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the keys to INTERMEDIATE_SORT_KEYS_BUFFER_BINDING and the indices to 
+    INTERMEDIATE_SORT_INDICES_BUFFER_BINDING.  Both are ranges of the same buffer.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void IntermediateDataSsbo::Bind() const
+{
+    unsigned int keysByteSize = _numItems * 2 * _numKeyWords * sizeof(unsigned int);
+    unsigned int indicesByteSize = _numItems * 2 * sizeof(unsigned int);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INTERMEDIATE_SORT_KEYS_BUFFER_BINDING, _bufferId, 
+        0, keysByteSize);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INTERMEDIATE_SORT_INDICES_BUFFER_BINDING, _bufferId, 
+        _indicesByteOffset, indicesByteSize);
 }
 
 /*------------------------------------------------------------------------------------------------
@@ -67,3 +101,17 @@ unsigned int IntermediateDataSsbo::NumItems() const
     return _numItems;
 }
 
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for where the indices start in the buffer (after the keys).  The first half
+    of the indices starts here.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int IntermediateDataSsbo::IndicesByteOffset() const
+{
+    return _indicesByteOffset;
+}
@@ -3,8 +3,6 @@
 #include "ThirdParty/glload/include/glload/gl_4_4.h"
 #include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
 
-#include "Include/SSBOs/OriginalData.h"
-
 #include <vector>
 
 /*------------------------------------------------------------------------------------------------
@@ -12,22 +10,35 @@ Description:
     Initializes base class, then gives derived class members initial values and allocates space 
     for the SSBO.
 Parameters: 
-    numItems    However many instances of OriginalData the user wants to store.
+    numItems        Same as the OriginalDataSsbo's.
+    itemSizeBytes   Same as the OriginalDataSsbo's.
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
-OriginalDataCopySsbo::OriginalDataCopySsbo(unsigned int numItems) :
+OriginalDataCopySsbo::OriginalDataCopySsbo(unsigned int numItems, unsigned int itemSizeBytes) :
     SsboBase()  // generate buffers
 {
-    std::vector<OriginalData> v(numItems);
+    std::vector<unsigned char> v(numItems * itemSizeBytes);
 
     // now bind this new buffer to the dedicated buffer binding location
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ORIGINAL_DATA_COPY_BUFFER_BINDING, _bufferId);
+    Bind();
 
     // OriginalDataSsbo already gave uOriginalDataBufferSize a value
 
     // and fill it with new data
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(OriginalData), v.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size(), v.data(), GL_DYNAMIC_DRAW);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the buffer to ORIGINAL_DATA_COPY_BUFFER_BINDING.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void OriginalDataCopySsbo::Bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ORIGINAL_DATA_COPY_BUFFER_BINDING, _bufferId);
+}
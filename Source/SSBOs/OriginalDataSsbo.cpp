@@ -4,8 +4,6 @@
 #include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
 #include "Shaders/ComputeHeaders/UniformLocations.comp"
 
-#include "Include/SSBOs/OriginalData.h"
-
 #include <vector>
 
 /*------------------------------------------------------------------------------------------------
@@ -13,25 +11,40 @@ Description:
     Initializes base class, then gives derived class members initial values and allocates space 
     for the SSBO.
 Parameters: 
-    numItems    However many instances of OriginalData the user wants to store.
+    numItems        However many items the user wants to store.
+    itemSizeBytes   The size of each item.  Defaults to the demo's OriginalData structure.
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
-OriginalDataSsbo::OriginalDataSsbo(unsigned int numItems) :
+OriginalDataSsbo::OriginalDataSsbo(unsigned int numItems, unsigned int itemSizeBytes) :
     SsboBase(),  // generate buffers
-    _numItems(numItems)
+    _numItems(numItems),
+    _itemSizeBytes(itemSizeBytes)
 {
-    std::vector<OriginalData> v(numItems);
+    // the std::vector<...>(...) constructor will set everything to 0
+    std::vector<unsigned char> v(numItems * itemSizeBytes);
 
     // now bind this new buffer to the dedicated buffer binding location
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ORIGINAL_DATA_BUFFER_BINDING, _bufferId);
+    Bind();
 
     // and fill it with new data
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(OriginalData), v.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size(), v.data(), GL_DYNAMIC_DRAW);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the buffer to ORIGINAL_DATA_BUFFER_BINDING.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void OriginalDataSsbo::Bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ORIGINAL_DATA_BUFFER_BINDING, _bufferId);
+}
+
 /*------------------------------------------------------------------------------------------------
 Description:
     Defines the buffer's size uniform in the specified shader.  It uses the #define'd uniform 
@@ -66,3 +79,16 @@ unsigned int OriginalDataSsbo::NumItems() const
 {
     return _numItems;
 }
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for the value that was passed in on creation.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int OriginalDataSsbo::ItemSizeBytes() const
+{
+    return _itemSizeBytes;
+}
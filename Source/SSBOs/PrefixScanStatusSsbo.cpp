@@ -0,0 +1,100 @@
+#include "Include/SSBOs/PrefixScanStatusSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+#include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
+#include "Shaders/ParallelSort/ParallelSortConstants.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes the base class, then initializes derived class members and allocates space for 
+    the SSBO.
+Parameters: 
+    numTiles        How many sort tiles there are.  Each one needs a status for every digit 
+                    value in each of the 2 status regions.
+    keyWidthBits    Decides how many words of key bits and how many passes' worth of digit 
+                    totals there are.  Must be the same as the shaders' 
+                    PARALLEL_SORT_KEY_WIDTH_BITS.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+PrefixScanStatusSsbo::PrefixScanStatusSsbo(unsigned int numTiles, unsigned int keyWidthBits) :
+    SsboBase(),  // generate buffers
+    _numTiles(numTiles),
+    _numUintsBeforeTileStatuses(0)
+{
+    // the std::vector<...>(...) constructor will set everything to 0
+    // Note: See PrefixScanStatusBuffer.comp for the layout.
+    unsigned int numTileCounters = 2;
+    unsigned int numKeyBits = 2 * PARALLEL_SORT_NUM_KEY_WORDS_FOR_KEY_WIDTH(keyWidthBits);
+    unsigned int numPositionBounds = 2 * 3;
+    unsigned int numKeysOutOfOrder = 2 + 1;
+    unsigned int numDigitTotals = PARALLEL_SORT_NUM_PASSES_FOR_KEY_WIDTH(keyWidthBits) * PARALLEL_SORT_NUM_DIGIT_VALUES;
+    unsigned int numTileStatuses = 2 * numTiles * PARALLEL_SORT_NUM_DIGIT_VALUES;
+    _numUintsBeforeTileStatuses = numTileCounters + numKeyBits + numPositionBounds + numKeysOutOfOrder + numDigitTotals;
+    std::vector<unsigned int> v(_numUintsBeforeTileStatuses + numTileStatuses);
+
+    // now bind this new buffer to the dedicated buffer binding location
+    Bind();
+
+    // and fill it with 0s
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the buffer to PREFIX_SCAN_STATUS_BUFFER_BINDING.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void PrefixScanStatusSsbo::Bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_STATUS_BUFFER_BINDING, _bufferId);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Sets the tile counters, the key bits, the position bounds, the out-of-order counts, the 
+    digit totals, and the tile statuses of the tiles that the sort uses back to 0.  This must 
+    be done before every sort (but not before every pass; see PrefixScanStatusBuffer.comp).
+
+    The status regions are as big as the sort's grid of tiles (see PREFIX_SCAN_STATUS_REGION_SIZE 
+    in PrefixScanStatusBuffer.comp), so a sort of fewer tiles than there is room for only uses 
+    the beginning of the buffer, and only that is cleared.
+
+    Note: This is a buffer clear, not a shader, so there is no need for a glMemoryBarrier(...) 
+    before the scan.  Buffer clears are finished before later commands read the buffer.
+Parameters: 
+    numTilesUsed    How many sort tiles the sort has.  Must be <= NumTiles().
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void PrefixScanStatusSsbo::Reset(unsigned int numTilesUsed) const
+{
+    unsigned int numTileStatuses = 2 * numTilesUsed * PARALLEL_SORT_NUM_DIGIT_VALUES;
+    unsigned int numUints = _numUintsBeforeTileStatuses + numTileStatuses;
+
+    // Note: A null data pointer fills the range with 0s.
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, numUints * sizeof(unsigned int), 
+        GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the number of sort tiles that statuses were allocated for.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PrefixScanStatusSsbo::NumTiles() const
+{
+    return _numTiles;
+}
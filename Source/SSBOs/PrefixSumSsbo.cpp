@@ -13,16 +13,15 @@ Description:
     Further explanation of the number of data entries:
     ----------------------------------------------------------------------------------------------
 
-    This algorithm has each thread working on 2 data items, so the usual uMaxDataCount uniform 
+    This algorithm has each thread working on several data items, so the usual uMaxDataCount uniform 
     doesn't have much use as a thread check, but a "max thread count" does.  This value is 
     determined in ParallelSort::Sort().  
 
     "Max thread count" = num work groups * threads per work group
 
     Problem: The algorithm relies on a binary tree within a work group's data set, so the number 
-    of items that are being summed within a work group must be a power of 2.  Each thread works 
-    on 2 items, so the number of threads per work group is also a power of 2 
-    (work group size = 256/512/etc.).  We humans like to have our data sets as multiples of 10 
+    of threads' sums that are being summed within a work group must be a power of 2, so the 
+    number of threads per work group is also a power of 2 (work group size = 256/512/etc.).  We humans like to have our data sets as multiples of 10 
     though, so data set sizes often don't divide evenly by a work group size (256/512/etc.).  
 
     Solution: Make the variable data set sizes work with the algorithm's reliance on a power of 
@@ -35,8 +34,9 @@ Description:
     concern myself with trying to optimize that last group's threads.  It is easier to just pad 
     the data and give the threads something to chew on.  Like hay for horses.  It's cheap.
 
-    In the following examples, work group size = 512, so
-    ITEMS_PER_WORK_GROUP = work group size * 2 = 1024.
+    In the following examples, work group size = 512 and PREFIX_SCAN_ITEMS_PER_THREAD = 2, so
+    ITEMS_PER_WORK_GROUP = work group size * 2 = 1024.  The math is the same for more items per 
+    thread, just with bigger work groups' worth of data.
 
     Ex 1: data size = 42
     allocated data  = ((42 / 1024) + (42 % 1024 == 0) ? 0 : 1) * 1024
@@ -98,6 +98,12 @@ Description:
     doesn't seem wasteful anymore.  
 
     ParallelPrefixScan does its best work on large data sets (100,000+).
+
+    Note: Since the Radix Sort switched to multi-bit digits, the data that is being scanned is 
+    the per-work-group digit counts, not the items themselves, but the same padding logic 
+    applies.  Padded entries are never given a count, so they may pick up junk from previous 
+    scans, but they are always at the end of the array, and a prefix sum is only affected by 
+    the entries before it, so the junk never makes its way into a real entry's prefix sum.
 Creator:    John Cox, 3-2017
 ------------------------------------------------------------------------------------------------*/
 
@@ -106,45 +112,66 @@ Creator:    John Cox, 3-2017
 Description:
     Initializes the base class, then initializes derived class members and allocates space for 
     the SSBO.
+
+    A single work group can only scan ITEMS_PER_WORK_GROUP values, so the sums of each work 
+    group need to be scanned too, and if there are more than ITEMS_PER_WORK_GROUP work groups, 
+    then the sums of those sums need to be scanned, and so on.  Each of these is a "level" (see 
+    PrefixScanBuffer.comp).  Each level is padded out to a whole number of work groups in the 
+    same manner as the data entries (see explanation essay at the top of the file).  
+
+    Ex: data size = 5,000,000
+    level 0 = 5,000,000 rounded up to 4,883 work groups = 5,000,192 entries
+    level 1 = 4,883 sums rounded up to 5 work groups    = 5,120 entries
+    level 2 = 5 sums rounded up to 1 work group         = 1,024 entries
+    Level 2 only has 1 work group, so it is the top level, and its sum goes in 1 last uint.
 Parameters: 
-    numDataEntries  How many items the user wants to have.  The only restriction is that it be 
-    less than (due to restrictions in the ParallelPrefixScan) 1024x1024 = 1,048,576.
+    numDataEntries  How many values need to be scanned.  For the Radix Sort, this is the number 
+    of per-work-group digit counts (see GetDigitCountsForPrefixScan.comp), not the number of 
+    items being sorted.  
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 PrefixSumSsbo::PrefixSumSsbo(unsigned int numDataEntries) :
     SsboBase(),  // generate buffers
-    _numPerGroupPrefixSums(0),
     _numDataEntries(0)
 {
     // see explanation essay at the top of the file
-    // Note: If the user passes in a data set of size 0, then the following calculation 
-    // will give a number of data entries of 0, so the number of work groups calculated in the 
-    // ParallelSort compute controller will lso be 0 and the sorting process will go nowhere.  
-    // At least it won't crash.
+    // Note: If the user passes in a data set of size 0, then there will still be 1 work group's 
+    // worth of data entries.  Nothing will be sorted, but there will always be a top level.
     _numDataEntries = (numDataEntries / ITEMS_PER_WORK_GROUP);
     _numDataEntries += (numDataEntries % ITEMS_PER_WORK_GROUP == 0) ? 0 : 1;
+    _numDataEntries = (_numDataEntries == 0) ? 1 : _numDataEntries;
     _numDataEntries *= ITEMS_PER_WORK_GROUP;
 
-    // use one work group's worth of data for the per-work-group prefix sums
-    // Note: The prefix scan of the "per work group sums" is a necessary step in preparation for 
-    // Radix Sort, so the individual work groups' prefix sums are rather useless without the 
-    // results of each work group being tallied and one more chunk of data is required.  This 
-    // data will also have the prefix scan run on it, so it must be the size of one work group's 
-    // worth of data.  
-    // Also Note: If the original data set is larger than 
-    // ITEMS_PER_WORK_GROUP * ITEMS_PER_WORK_GROUP 
-    // (number of work group sums * amount of data that each work group operates on), then 
-    // ITEMS_PER_WORK_GROUP will need to be increased.
-    _numPerGroupPrefixSums = ITEMS_PER_WORK_GROUP;
+    // keep adding levels until a level fits in a single work group
+    // Note: There are always at least 2 levels.  Even if the data entries fit in a single work 
+    // group, the sorting shaders still read that work group's prefix sum (0) from level 1.
+    unsigned int levelOffset = 0;
+    unsigned int levelSize = _numDataEntries;
+    while (true)
+    {
+        _levelOffsets.push_back(levelOffset);
+        _levelSizes.push_back(levelSize);
+        levelOffset += levelSize;
+
+        unsigned int numWorkGroups = levelSize / ITEMS_PER_WORK_GROUP;
+        if (numWorkGroups == 1 && _levelSizes.size() > 1)
+        {
+            break;
+        }
+
+        levelSize = (numWorkGroups / ITEMS_PER_WORK_GROUP);
+        levelSize += (numWorkGroups % ITEMS_PER_WORK_GROUP == 0) ? 0 : 1;
+        levelSize *= ITEMS_PER_WORK_GROUP;
+    }
 
     // the std::vector<...>(...) constructor will set everything to 0
-    // Note: The +1 is because of a single uint in the buffer, totalNumberOfOnes.  See 
-    // explanation in PrefixScanBuffer.comp.
-    std::vector<unsigned int> v(_numPerGroupPrefixSums + 1 + _numDataEntries);
+    // Note: The +1 is for the sum of the top level's single work group.  See explanation in 
+    // PrefixScanBuffer.comp.
+    std::vector<unsigned int> v(levelOffset + 1);
 
     // now bind this new buffer to the dedicated buffer binding location
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_BUFFER_BINDING, _bufferId);
+    Bind();
 
     // and fill it with 0s
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
@@ -152,6 +179,18 @@ PrefixSumSsbo::PrefixSumSsbo(unsigned int numDataEntries) :
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the buffer to PREFIX_SCAN_BUFFER_BINDING.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void PrefixSumSsbo::Bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_BUFFER_BINDING, _bufferId);
+}
+
 /*------------------------------------------------------------------------------------------------
 Description:
     Defines the buffer's size uniform in the specified shader.  It uses the #define'd uniform 
@@ -176,31 +215,64 @@ void PrefixSumSsbo::ConfigureConstantUniforms(unsigned int computeProgramId) con
 
 /*------------------------------------------------------------------------------------------------
 Description:
-    Returns the number of integers that have been allocated for the PrefixSumsByGroup array.  
-    The constructor ensures that this is the size of 1, and only 1, work group's worth of data 
-    for the PrefixSumsByGroup array.
+    Returns the number of integers that have been allocated for level 0 of the prefix sums 
+    (the PrefixSumsWithinGroup).  The constructor ensures that there are enough entries for 
+    every item to be part of a work group.  
 Parameters: None
 Returns:    
     See Description.
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
-unsigned int PrefixSumSsbo::NumPerGroupPrefixSums() const
+unsigned int PrefixSumSsbo::NumDataEntries() const
 {
-    return _numPerGroupPrefixSums;
+    return _numDataEntries;
 }
 
 /*------------------------------------------------------------------------------------------------
 Description:
-    Returns the number of integers that have been allocated for the PrefixSumsWithinGroup array.  The 
-    constructor ensures that there are enough entries for every item to be part of a work group.  
+    Returns the number of levels of prefix sums.  There are always at least 2.
 Parameters: None
 Returns:    
     See Description.
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
-unsigned int PrefixSumSsbo::NumDataEntries() const
+unsigned int PrefixSumSsbo::NumLevels() const
 {
-    return _numDataEntries;
+    return _levelSizes.size();
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the index in PrefixScanBuffer::AllPrefixSums where the requested level starts.  If 
+    the level is the one above the top level, then this is the index of the top level's sum.
+Parameters: 
+    level   0 is the data entries.  Must be <= NumLevels().
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PrefixSumSsbo::LevelOffset(unsigned int level) const
+{
+    if (level == _levelOffsets.size())
+    {
+        // the top level's sum is right after the top level
+        return _levelOffsets.back() + _levelSizes.back();
+    }
+
+    return _levelOffsets[level];
+}
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the number of integers that have been allocated for the requested level.  It is 
+    always a multiple of ITEMS_PER_WORK_GROUP.
+Parameters: 
+    level   0 is the data entries.  Must be < NumLevels().
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PrefixSumSsbo::LevelSize(unsigned int level) const
+{
+    return _levelSizes[level];
+}
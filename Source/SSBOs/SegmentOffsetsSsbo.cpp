@@ -0,0 +1,74 @@
+#include "Include/SSBOs/SegmentOffsetsSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
+#include "Shaders/ComputeHeaders/UniformLocations.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes the base class, then initializes derived class members and allocates space for
+    the SSBO.
+Parameters:
+    numSegments     How many segments the original data is split into.  One offset each.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+SegmentOffsetsSsbo::SegmentOffsetsSsbo(unsigned int numSegments) :
+    SsboBase(),  // generate buffers
+    _numSegments(numSegments)
+{
+    // the std::vector<...>(...) constructor will set everything to 0
+    std::vector<unsigned int> v(numSegments);
+
+    // now bind this new buffer to the dedicated buffer binding location
+    Bind();
+
+    // and fill it with 0s
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the buffer to SEGMENT_OFFSETS_BUFFER_BINDING.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SegmentOffsetsSsbo::Bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SEGMENT_OFFSETS_BUFFER_BINDING, _bufferId);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Defines the buffer's size uniform in the specified shader.  It uses the #define'd uniform
+    location found in UniformLocations.comp.
+Parameters:
+    computeProgramId    Self-explanatory.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SegmentOffsetsSsbo::ConfigureConstantUniforms(unsigned int computeProgramId) const
+{
+    // the uniform should remain constant after this
+    glUseProgram(computeProgramId);
+    glUniform1ui(UNIFORM_LOCATION_SEGMENT_OFFSETS_BUFFER_SIZE, _numSegments);
+    glUseProgram(0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for the value that was passed in on creation.
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SegmentOffsetsSsbo::NumSegments() const
+{
+    return _numSegments;
+}
@@ -0,0 +1,176 @@
+#include "Include/SSBOs/SelectStatusSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+#include "Include/SSBOs/SelectPass.h"
+
+#include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
+#include "Shaders/ParallelSort/ParallelSortConstants.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes the base class, then initializes derived class members and allocates space for
+    the SSBO.
+Parameters:
+    numItems        How many items are in the original data.  Up to all of them can be
+                    selected.
+    numWorkGroupsX  The 2D grid of work groups that the first pass is run with (1 thread per
+    numWorkGroupsY  original data item).
+    keyWidthBits    Decides how many passes and how many words of key there are.  Must be the
+                    same as the shaders' PARALLEL_SORT_KEY_WIDTH_BITS.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+SelectStatusSsbo::SelectStatusSsbo(unsigned int numItems, unsigned int numWorkGroupsX,
+    unsigned int numWorkGroupsY, unsigned int keyWidthBits) :
+    SsboBase(),  // generate buffers
+    _numItems(numItems),
+    _numWorkGroupsX(numWorkGroupsX),
+    _numWorkGroupsY(numWorkGroupsY),
+    _numPasses(PARALLEL_SORT_NUM_PASSES_FOR_KEY_WIDTH(keyWidthBits)),
+    _numKeyWords(PARALLEL_SORT_NUM_KEY_WORDS_FOR_KEY_WIDTH(keyWidthBits)),
+    _selectedIndicesByteOffset(0)
+{
+    // the selected indices start after the status, but a range that is bound to a binding
+    // point has to start on a multiple of the implementation's alignment
+    int offsetAlignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    unsigned int statusByteSize = StatusSizeBytes();
+    _selectedIndicesByteOffset =
+        ((statusByteSize + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
+    unsigned int selectedIndicesByteSize = ((numItems == 0) ? 1 : numItems) * sizeof(unsigned int);
+
+    // the std::vector<...>(...) constructor will set everything to 0
+    std::vector<unsigned int> v((_selectedIndicesByteOffset + selectedIndicesByteSize) / sizeof(unsigned int));
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // now bind each part of this new buffer to its dedicated buffer binding location
+    Bind();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the status to SELECT_STATUS_BUFFER_BINDING and the selected indices to
+    SELECTED_INDICES_BUFFER_BINDING.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SelectStatusSsbo::Bind() const
+{
+    unsigned int selectedIndicesByteSize = ((_numItems == 0) ? 1 : _numItems) * sizeof(unsigned int);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SELECT_STATUS_BUFFER_BINDING, _bufferId,
+        0, StatusSizeBytes());
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SELECTED_INDICES_BUFFER_BINDING, _bufferId,
+        _selectedIndicesByteOffset, selectedIndicesByteSize);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Sets up the status for a new select: The first pass looks at all the original data, the
+    passes after it have 0 work groups until PickSelectDigit.comp fills them out, and
+    everything else starts at 0.
+
+    Note: This is a buffer update, not a shader, so there is no need for a
+    glMemoryBarrier(...) before the first pass.
+Parameters:
+    targetRank  The rank of the wanted key among all the original data (0 for the smallest).
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SelectStatusSsbo::Reset(unsigned int targetRank) const
+{
+    std::vector<unsigned int> v(StatusSizeBytes() / sizeof(unsigned int));
+
+    // the first pass is over the most significant digit, which is the last one in the array
+    SelectPass *passes = reinterpret_cast<SelectPass *>(v.data());
+    SelectPass &firstPass = passes[_numPasses - 1];
+    firstPass._numWorkGroupsX = _numWorkGroupsX;
+    firstPass._numWorkGroupsY = _numWorkGroupsY;
+    firstPass._numWorkGroupsZ = 1;
+    firstPass._numCandidates = _numItems;
+
+    // Note: TargetRank is right after the passes (see SelectStatusBuffer.comp).
+    v[_numPasses * sizeof(SelectPass) / sizeof(unsigned int)] = targetRank;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, v.size() * sizeof(unsigned int), v.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the byte offset into the buffer of the pass' work group counts for
+    glDispatchComputeIndirect(...).
+Parameters:
+    passNumber  0 for the pass over the least significant digit.
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SelectStatusSsbo::IndirectDispatchOffset(unsigned int passNumber) const
+{
+    // Note: The work group counts are the first thing in the SelectPass structure.
+    return passNumber * sizeof(SelectPass);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Reads SelectStatusBuffer::SelectedKey back from the GPU.  This makes the CPU wait for the
+    select to finish.  The caller must have issued a
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT) after the last pass.
+Parameters: None
+Returns:
+    The key's bits as they are in the original data.  Keys of up to 32 bits are in the low
+    word.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long SelectStatusSsbo::GetSelectedKey() const
+{
+    // Note: SelectedKey is the last thing in the status.
+    unsigned int keyWords[2] = { 0, 0 };
+    unsigned int byteOffset = StatusSizeBytes() - (_numKeyWords * sizeof(unsigned int));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, byteOffset, _numKeyWords * sizeof(unsigned int), keyWords);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return (static_cast<unsigned long long>(keyWords[1]) << 32) | keyWords[0];
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for where the selected indices start in the buffer.
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SelectStatusSsbo::SelectedIndicesByteOffset() const
+{
+    return _selectedIndicesByteOffset;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Adds up the size of SelectStatusBuffer (see SelectStatusBuffer.comp for the layout):
+    - the passes
+    - TargetRank, NumSelected, NumNextCandidates, and TiesSelectedOffset
+    - DigitCounts
+    - SelectedKeyBits and SelectedKey
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SelectStatusSsbo::StatusSizeBytes() const
+{
+    unsigned int numCounters = 4;
+    unsigned int numUints = numCounters + PARALLEL_SORT_NUM_DIGIT_VALUES + (2 * _numKeyWords);
+    return (_numPasses * sizeof(SelectPass)) + (numUints * sizeof(unsigned int));
+}
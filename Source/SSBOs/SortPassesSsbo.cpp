@@ -0,0 +1,160 @@
+#include "Include/SSBOs/SortPassesSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+#include "Include/SSBOs/SortPass.h"
+
+#include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
+#include "Shaders/ComputeHeaders/UniformLocations.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes the base class, then initializes derived class members and allocates space for
+    the SSBO.
+Parameters:
+    numWorkGroupsX  The 2D grid of work groups that a pass is run with if it isn't skipped (1
+    numWorkGroupsY  work group per sort tile).
+    numPasses       Must be the same as the shaders' PARALLEL_SORT_NUM_PASSES.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+SortPassesSsbo::SortPassesSsbo(unsigned int numWorkGroupsX, unsigned int numWorkGroupsY, unsigned int numPasses) :
+    SsboBase(),  // generate buffers
+    _numWorkGroupsX(numWorkGroupsX),
+    _numWorkGroupsY(numWorkGroupsY),
+    _numPasses(numPasses)
+{
+    // the std::vector<...>(...) constructor will set everything to 0, so until
+    // PlanSortPasses.comp fills it out, every pass has 0 work groups
+    // Note: See SortPassesBuffer.comp for the layout.  The 8 extra uints are
+    // FinalIntermediateBufferReadOffset, NumPassesRun, and the repair and gather work group 
+    // counts.
+    unsigned int numUints = (numPasses * sizeof(SortPass) / sizeof(unsigned int)) + 8;
+    std::vector<unsigned int> v(numUints);
+
+    // now bind this new buffer to the dedicated buffer binding location
+    Bind();
+
+    // and fill it with 0s
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the buffer to SORT_PASSES_BUFFER_BINDING.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SortPassesSsbo::Bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SORT_PASSES_BUFFER_BINDING, _bufferId);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Changes the number of work groups that ConfigureConstantUniforms(...) gives the shaders.  
+    ParallelSort calls this when a sort has a different number of sort tiles than the one 
+    before it, then configures the shaders again.
+Parameters:
+    numWorkGroupsX  The 2D grid of work groups that a pass is run with if it isn't skipped (1
+    numWorkGroupsY  work group per sort tile).
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SortPassesSsbo::SetNumWorkGroups(unsigned int numWorkGroupsX, unsigned int numWorkGroupsY)
+{
+    _numWorkGroupsX = numWorkGroupsX;
+    _numWorkGroupsY = numWorkGroupsY;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Gives PlanSortPasses.comp the number of work groups to give the passes that aren't skipped.
+Parameters:
+    computeProgramId    Self-explanatory.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SortPassesSsbo::ConfigureConstantUniforms(unsigned int computeProgramId) const
+{
+    // the uniforms should remain constant after this until the number of work groups changes
+    glUseProgram(computeProgramId);
+    glUniform1ui(UNIFORM_LOCATION_SORT_PASSES_NUM_WORK_GROUPS_X, _numWorkGroupsX);
+    glUniform1ui(UNIFORM_LOCATION_SORT_PASSES_NUM_WORK_GROUPS_Y, _numWorkGroupsY);
+    glUseProgram(0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the byte offset into the buffer of the pass' work group counts for
+    glDispatchComputeIndirect(...).
+Parameters:
+    passNumber  0 for the pass over the least significant digit.
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortPassesSsbo::IndirectDispatchOffset(unsigned int passNumber) const
+{
+    // Note: The work group counts are the first thing in the SortPass structure.
+    return passNumber * sizeof(SortPass);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the byte offset into the buffer of an incremental sort's repair work group counts 
+    for glDispatchComputeIndirect(...).
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortPassesSsbo::RepairIndirectDispatchOffset() const
+{
+    // Note: The repair work group counts are after the passes, 
+    // FinalIntermediateBufferReadOffset, and NumPassesRun.
+    return (_numPasses * sizeof(SortPass)) + (2 * sizeof(unsigned int));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the byte offset into the buffer of an incremental sort's gather work group counts 
+    (for the gather into the sorted copy and the copy back) for glDispatchComputeIndirect(...).
+Parameters: None
+Returns:
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortPassesSsbo::GatherIndirectDispatchOffset() const
+{
+    // Note: The gather work group counts are right after the repair's.
+    return RepairIndirectDispatchOffset() + (3 * sizeof(unsigned int));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Reads SortPassesBuffer::NumPassesRun back from the GPU.  This makes the CPU wait for
+    PlanSortPasses.comp to finish, so it is only meant for after the sort is over (ex:
+    profiling).  The caller must have issued a glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT)
+    after that shader.
+Parameters: None
+Returns:
+    How many of the passes were not skipped.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortPassesSsbo::GetNumPassesRun() const
+{
+    // Note: NumPassesRun is after the passes and FinalIntermediateBufferReadOffset.
+    unsigned int numPassesRun = 0;
+    unsigned int byteOffset = (_numPasses * sizeof(SortPass)) + sizeof(unsigned int);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, byteOffset, sizeof(numPassesRun), &numPassesRun);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return numPassesRun;
+}
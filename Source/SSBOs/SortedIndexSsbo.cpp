@@ -0,0 +1,96 @@
+#include "Include/SSBOs/SortedIndexSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ComputeHeaders/SsboBufferBindings.comp"
+#include "Shaders/ParallelSort/ParallelSortConstants.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then gives derived class members initial values and allocates space 
+    for the SSBO.  The first run is bound.
+Parameters: 
+    numItems    The most items that the run can have.  Rounded up to a multiple of the work 
+                group size so that the second run starts on a multiple of the binding offset 
+                alignment.
+    numKeyWords How many uints each key takes up (see SortKey.comp).
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+SortedIndexSsbo::SortedIndexSsbo(unsigned int numItems, unsigned int numKeyWords) :
+    SsboBase(),  // generate buffers
+    _numItems(0),
+    _numKeyWords(numKeyWords),
+    _indicesByteOffset(0)
+{
+    // Note: A range that is bound to a binding point has to start on a multiple of the 
+    // implementation's alignment, and a run of a multiple of the work group size is a multiple 
+    // of 2KB, which is more than any alignment in practice.
+    _numItems = ((numItems + PARALLEL_SORT_WORK_GROUP_SIZE_X - 1) / PARALLEL_SORT_WORK_GROUP_SIZE_X) * PARALLEL_SORT_WORK_GROUP_SIZE_X;
+    _numItems = (_numItems == 0) ? PARALLEL_SORT_WORK_GROUP_SIZE_X : _numItems;
+
+    unsigned int keysByteSize = _numItems * 2 * numKeyWords * sizeof(unsigned int);
+    unsigned int indicesByteSize = _numItems * 2 * sizeof(unsigned int);
+    int offsetAlignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    _indicesByteOffset = 
+        ((keysByteSize + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
+
+    // the std::vector<...>(...) constructor will set everything to 0
+    std::vector<unsigned int> v((_indicesByteOffset + indicesByteSize) / sizeof(unsigned int));
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    BindRun(0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds one run's keys and indices to their dedicated buffer binding locations so that 
+    shaders see that run at index 0.
+Parameters: 
+    runOffset   0 for the first run, NumItems() for the second.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SortedIndexSsbo::BindRun(unsigned int runOffset) const
+{
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SORTED_INDEX_KEYS_BUFFER_BINDING, _bufferId, 
+        runOffset * _numKeyWords * sizeof(unsigned int), _numItems * _numKeyWords * sizeof(unsigned int));
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SORTED_INDEX_ORIGINAL_INDICES_BUFFER_BINDING, _bufferId, 
+        _indicesByteOffset + (runOffset * sizeof(unsigned int)), _numItems * sizeof(unsigned int));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds both runs' keys and indices to their dedicated buffer binding locations for a merge 
+    from one run to the other.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SortedIndexSsbo::BindBothRuns() const
+{
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SORTED_INDEX_KEYS_BUFFER_BINDING, _bufferId, 
+        0, _numItems * 2 * _numKeyWords * sizeof(unsigned int));
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SORTED_INDEX_ORIGINAL_INDICES_BUFFER_BINDING, _bufferId, 
+        _indicesByteOffset, _numItems * 2 * sizeof(unsigned int));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for the size of each run (the value that was passed in on creation, 
+    rounded up).
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int SortedIndexSsbo::NumItems() const
+{
+    return _numItems;
+}
@@ -58,6 +58,24 @@ SsboBase::~SsboBase()
     glDeleteVertexArrays(1, &_vaoId);
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the buffer to its dedicated binding point(s) (see SsboBufferBindings.comp).  The 
+    shaders find their buffers by binding point, not by buffer ID, so when there is more than 
+    one buffer for the same binding point (ex: two ParallelSorts), the compute controllers call 
+    this before they run their shaders.  Derived classes bind themselves in their constructors 
+    too.
+
+    The method does nothing though.  Override as needed.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SsboBase::Bind() const
+{
+    // nothing
+}
+
 /*------------------------------------------------------------------------------------------------
 Description:
     This is a convenience method for setting constant values, like buffer sizes, that must be 
@@ -167,3 +185,22 @@ unsigned int SsboBase::NumVertices() const
 //    return ssboBindingPointIndex++;
 //}
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Trades buffers with another SSBO of the same size, so that each one has what the other had 
+    without copying anything.  Used to swap a double-buffered pair (ex: the original data and 
+    its sorted copy; see ParallelSort::Sort()).
+
+    Note: Only the buffer IDs are traded.  The VAOs, and any binding points or VAOs that the 
+    buffers are attached to, stay where they are, so the caller must rebind them.
+Parameters: 
+    other   Self-explanatory.
+Returns:    None
+Creator:    John Cox, 3/2017
+------------------------------------------------------------------------------------------------*/
+void SsboBase::SwapBufferIds(SsboBase &other)
+{
+    unsigned int bufferId = _bufferId;
+    _bufferId = other._bufferId;
+    other._bufferId = bufferId;
+}
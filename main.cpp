@@ -151,12 +151,18 @@ void Init()
 
     parallelSort = std::make_unique<ParallelSort>(originalData);
 
+    // this is a demo, so time each step of the sort and check the results, and time them on 
+    // the GPU too
+    parallelSort->EnableDiagnostics(true);
+    parallelSort->EnableGpuProfiling(true);
+
     // the sort's so nice, I did it twice
     // Note: Actually, I did it twice because the first time is slowed down on the first calls 
     // to the compute shaders as any data that OpenGL has staged in system memory is copied to 
     // the GPU.  That doesn't happen on the second run through the shaders, so I just run the 
-    // whole sort a second run
+    // whole sort a second run, and the GPU profile is started over for it
     parallelSort->Sort();
+    parallelSort->ResetGpuProfile();
     parallelSort->Sort();
 
     // the timer will be used for framerate calculations
@@ -329,6 +335,9 @@ Creator:    John Cox (2-13-2016)
 ------------------------------------------------------------------------------------------------*/
 void CleanupAll()
 {
+    // the sort deletes its programs from the ShaderStorage singleton, so it has to go while 
+    // that (and the OpenGL context) is still around instead of at static destruction
+    parallelSort = nullptr;
 }
 
 /*------------------------------------------------------------------------------------------------